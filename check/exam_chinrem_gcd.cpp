@@ -28,6 +28,7 @@ using namespace std;
 
 namespace GiNaC {
 extern ex chinrem_gcd(const ex& A, const ex& B);
+extern ex chinrem_gcd(const ex& A, const ex& B, const exvector& vars, bool sparse);
 }
 
 using namespace GiNaC;
@@ -66,12 +67,33 @@ static void integer_coeff_braindamage()
 	}
 }
 
+static void check_sparse_gcd()
+{
+	parser readme;
+	ex G = readme("x*y^3*z + 2*w^2*x - 5*z^2*w + 7");
+	ex A = expand(G*readme("x^2*w + y*z^2 - 3"));
+	ex B = expand(G*readme("y*w^3 - x*z + 5"));
+	symtab syms = readme.get_syms();
+	exvector vars = {syms["w"], syms["z"], syms["y"], syms["x"]};
+	ex g = chinrem_gcd(A, B, vars, true);
+	if (!expand(g - G).is_zero() && !expand(g + G).is_zero()) {
+		std::cerr << "expected " << G << ", got " << g << std::endl;
+		throw std::logic_error("sparse chinrem_gcd miscomputed the GCD");
+	}
+	g = gcd(A, B);
+	if (!expand(g - G).is_zero() && !expand(g + G).is_zero()) {
+		std::cerr << "expected " << G << ", got " << g << std::endl;
+		throw std::logic_error("gcd miscomputed the GCD of sparse polynomials");
+	}
+}
+
 int main(int argc, char** argv)
 {
 	cout << "examining in poly_cra() and friends " << flush;
 	check_poly_cra();
 	check_extract_integer_content();
 	integer_coeff_braindamage();
+	check_sparse_gcd();
 	cout << "not found.";
 	return 0;
 }
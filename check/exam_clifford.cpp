@@ -588,6 +588,45 @@ static unsigned clifford_check9()
 	return result;
 }
 
+static unsigned clifford_check10()
+{
+	// products in the blade representation
+
+	unsigned result = 0;
+
+	realsymbol x("x"), y("y");
+	varidx mu(symbol("mu", "\\mu"), 4);
+
+	ex e = clifford_unit(mu, diag_matrix({1, -1, -1, 2}));
+	ex e0 = e.subs(mu==0);
+	ex e1 = e.subs(mu==1);
+	ex e2 = e.subs(mu==2);
+	ex e3 = e.subs(mu==3);
+	ex one = dirac_ONE();
+
+	result += check_equal(clifford_blade_form(e1*e0), -e0*e1);
+	result += check_equal(clifford_blade_form(e1*e0 + e0*e1), 0);
+	result += check_equal(clifford_blade_form(e3*e1*e3*e2), -2*e1*e2);
+	result += check_equal(clifford_blade_form((x*one + e0*e1) * (x*one - e0*e1)), (x*x - 1) * one);
+	result += check_equal(clifford_blade_form(pow(e0*e1*e2, 2)), -one);
+	result += check_equal(pow(clifford_norm(x*e0 + y*e3), 2), -x*x - 2*y*y);
+
+	// signs from the table of a small algebra
+	varidx nu(symbol("nu", "\\nu"), 2);
+	ex f = clifford_unit(nu, diag_matrix({1, 1}));
+	ex f0 = f.subs(nu==0);
+	ex f1 = f.subs(nu==1);
+	ex p = clifford_blade_form(f1*f0);
+	if (p.is_zero()) {
+		clog << "clifford_blade_form(" << f1*f0 << ") erroneously returned 0" << endl;
+		++result;
+	}
+	result += check_equal(p, -clifford_blade_form(f0*f1));
+	result += check_equal(clifford_blade_form(f0*f1*f0*f1), -dirac_ONE());
+
+	return result;
+}
+
 unsigned exam_clifford()
 {
 	unsigned result = 0;
@@ -657,6 +696,8 @@ unsigned exam_clifford()
 
 	result += clifford_check9(); cout << '.' << flush;
 
+	result += clifford_check10(); cout << '.' << flush;
+
 	return result;
 }
 
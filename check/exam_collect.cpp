@@ -133,6 +133,44 @@ static unsigned exam_collect_3()
 	return result;
 }
 
+// Single-pass collect of large expanded sums agrees with collecting one
+// object after the other.
+static unsigned exam_collect_4()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y"), p("p"), q("q");
+
+	ex a = expand(pow(1 + p*x - q*y + x*y/p, 8) + pow(x, -2)*y + sin(p)*x);
+
+	ex a_xy = a.collect(lst{x,y});
+	ex ref = a.collect(y).collect(x);
+	if (a_xy != ref) {
+		clog << "collect(" << a << ", {" << x << ", " << y << "}) erroneously returned "
+		     << a_xy << " instead of " << ref << endl;
+		++result;
+	}
+	if (!expand(a_xy - a).is_zero()) {
+		clog << "collect(" << a << ", {" << x << ", " << y << "}) changed the value" << endl;
+		++result;
+	}
+
+	ex a_d = a.collect(lst{x,y}, true);
+	for (int i = -2; i <= 8; ++i) {
+		for (int j = 0; j <= 8; ++j) {
+			ex c1 = a_d.coeff(x, i).coeff(y, j);
+			ex c2 = a.coeff(x, i).coeff(y, j);
+			if (!expand(c1 - c2).is_zero()) {
+				clog << "distributed collect(" << a << ", {" << x << ", " << y
+				     << "}) has wrong coefficient " << c1 << " of "
+				     << pow(x, i)*pow(y, j) << endl;
+				++result;
+			}
+		}
+	}
+
+	return result;
+}
+
 unsigned exam_collect()
 {
 	unsigned result = 0;
@@ -142,6 +180,7 @@ unsigned exam_collect()
 	result += exam_collect_1();  cout << '.' << flush;
 	result += exam_collect_2();  cout << '.' << flush;
 	result += exam_collect_3();  cout << '.' << flush;
+	result += exam_collect_4();  cout << '.' << flush;
 
 	return result;
 }
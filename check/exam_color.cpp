@@ -141,6 +141,15 @@ static unsigned color_check3()
 	result += check_equal_simplify(color_trace(e, 2), e);
 	result += check_equal_simplify(color_trace(e, lst{0, 1}), 2);
 
+	idx d(symbol("d"), 8), f(symbol("f"), 8), g(symbol("g"), 8), h(symbol("h"), 8), k(symbol("k"), 8);
+	e = color_T(a) * color_T(b) * color_T(c) * color_T(a) * color_T(b) * color_T(c);
+	result += check_equal_simplify(color_trace(e), numeric(10, 9));
+	e = color_T(a) * color_T(b) * color_T(c) * color_T(d);
+	result += check_equal_simplify(color_trace(e) * delta_tensor(c, d), 2 * delta_tensor(a, b) / 3);
+	ex e2 = color_T(f) * color_T(g) * color_T(h) * color_T(k);
+	result += check_equal_simplify(color_trace(e) * delta_tensor(c, d) * color_trace(e2) * delta_tensor(h, k),
+	                               4 * delta_tensor(a, b) * delta_tensor(f, g) / 9);
+
 	return result;
 }
 
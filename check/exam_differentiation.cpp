@@ -259,6 +259,179 @@ static unsigned exam_differentiation7()
 	return 0;
 }
 
+// Gradient, Jacobian and Hessian by reverse-mode differentiation
+static unsigned exam_differentiation8()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y"), z("z");
+	lst vars = {x, y, z};
+	ex s = sin(x*y);
+	ex e = x*y*s + exp(x+z)/(y+z) + pow(x, y) + pow(s, 2);
+
+	ex g = gradient(e, vars);
+	for (size_t i = 0; i < vars.nops(); ++i) {
+		ex d = e.diff(ex_to<symbol>(vars.op(i)));
+		if (!normal(g.op(i) - d).is_zero()) {
+			clog << "gradient of " << e << " returned " << g.op(i) << " for "
+			     << vars.op(i) << " instead of " << d << endl;
+			++result;
+		}
+	}
+
+	lst fs = {e, x*s, pow(y+z, 3)};
+	matrix J = ex_to<matrix>(jacobian(fs, vars));
+	for (size_t r = 0; r < fs.nops(); ++r) {
+		for (size_t c = 0; c < vars.nops(); ++c) {
+			ex d = fs.op(r).diff(ex_to<symbol>(vars.op(c)));
+			if (!normal(J(r, c) - d).is_zero()) {
+				clog << "jacobian of " << fs << " returned " << J(r, c) << " at ("
+				     << r << "," << c << ") instead of " << d << endl;
+				++result;
+			}
+		}
+	}
+
+	matrix H = ex_to<matrix>(hessian(e, vars));
+	for (size_t r = 0; r < vars.nops(); ++r) {
+		for (size_t c = 0; c < vars.nops(); ++c) {
+			ex d = e.diff(ex_to<symbol>(vars.op(r))).diff(ex_to<symbol>(vars.op(c)));
+			if (!normal(H(r, c) - d).is_zero()) {
+				clog << "hessian of " << e << " returned " << H(r, c) << " at ("
+				     << r << "," << c << ") instead of " << d << endl;
+				++result;
+			}
+		}
+	}
+
+	// functions with an explicit derivative do not follow the chain rule
+	realsymbol r("r"), t("t");
+	lst rvars = {r, t};
+	ex c = conjugate(pow(r, 2)) + r*abs(r + I*t);
+	g = gradient(c, rvars);
+	for (size_t i = 0; i < rvars.nops(); ++i) {
+		ex d = c.diff(ex_to<symbol>(rvars.op(i)));
+		if (!normal(g.op(i) - d).is_zero()) {
+			clog << "gradient of " << c << " returned " << g.op(i) << " for "
+			     << rvars.op(i) << " instead of " << d << endl;
+			++result;
+		}
+	}
+
+	// expressions not depending on the variables
+	g = gradient(pow(z, 2), lst{x, y});
+	if (!g.op(0).is_zero() || !g.op(1).is_zero()) {
+		clog << "gradient of z^2 with respect to {x,y} returned " << g << endl;
+		++result;
+	}
+
+	return result;
+}
+
+// Higher and mixed derivatives, compared with repeated first derivatives
+static unsigned exam_differentiation9()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+	ex e = y*exp(sin(x))*pow(x+1, -3) + log(x*y+1) + pow(x, 7)*cos(x);
+
+	ex d = derivatives(e, x, 6);
+	if (d.nops() != 7 || !d.op(0).is_equal(e)) {
+		clog << "derivatives(" << e << ", " << x << ", 6) returned " << d << endl;
+		return 1;
+	}
+	ex it = e;
+	for (unsigned k = 1; k <= 6; ++k) {
+		it = it.diff(x);
+		if (!normal(d.op(k) - it).is_zero()) {
+			clog << "derivative of order " << k << " of " << e << " returned "
+			     << d.op(k) << " instead of " << it << endl;
+			++result;
+		}
+	}
+	if (!normal(e.diff(x, 6) - it).is_zero()) {
+		clog << "sixth derivative of " << e << " by " << x << " returned "
+		     << e.diff(x, 6) << " instead of " << it << endl;
+		++result;
+	}
+
+	ex m = mixed_diff(e, lst{x==2, y});
+	ex dm = e.diff(x).diff(x).diff(y);
+	if (!normal(m - dm).is_zero()) {
+		clog << "mixed derivative {x==2, y} of " << e << " returned " << m
+		     << " instead of " << dm << endl;
+		++result;
+	}
+
+	// functions with an explicit derivative are differentiated repeatedly
+	realsymbol r("r");
+	ex c = conjugate(pow(r, 3)*x) + r*abs(pow(r, 2) + I*x);
+	ex d3 = c.diff(r).diff(r).diff(r);
+	if (!normal(c.diff(r, 3) - d3).is_zero()) {
+		clog << "third derivative of " << c << " by " << r << " returned "
+		     << c.diff(r, 3) << " instead of " << d3 << endl;
+		++result;
+	}
+
+	// polynomials: derivatives beyond the degree vanish
+	if (!pow(x*y+1, 3).diff(x, 4).is_zero()) {
+		clog << "fourth derivative of (x*y+1)^3 by " << x << " is not zero" << endl;
+		++result;
+	}
+
+	return result;
+}
+
+// Numeric derivatives by Taylor arithmetic, compared with symbolic ones
+static unsigned exam_differentiation10()
+{
+	unsigned result = 0;
+	symbol x("x");
+	const numeric a(13, 10);
+	const unsigned order = 8;
+	ex e = exp(sin(x))*pow(x+1, -3) + atan(x*x) + asin(x/2) + log(x)*tanh(x)
+	     + x*cosh(x)/sqrt(x+2) + pow(x, x);
+
+	ex nd = numeric_derivatives(e, x, a, order);
+	ex d = e;
+	for (unsigned k = 0; k <= order; ++k) {
+		ex expect = d.subs(x==a).evalf();
+		ex err = abs(nd.op(k) - expect).evalf();
+		if (!is_a<numeric>(err) || ex_to<numeric>(err) > numeric(1, 1000000000)*(1+abs(ex_to<numeric>(expect)))) {
+			clog << "numeric derivative of order " << k << " of " << e << " at "
+			     << x << "==" << a << " returned " << nd.op(k) << " instead of "
+			     << expect << endl;
+			++result;
+		}
+		d = d.diff(x);
+	}
+
+	// functions with an explicit derivative
+	realsymbol r("r");
+	e = abs(r*r - 3) + real_part(exp(I*r));
+	nd = numeric_derivatives(e, r, a, 3);
+	d = e;
+	for (unsigned k = 0; k <= 3; ++k) {
+		ex expect = d.subs(r==a).evalf();
+		ex err = abs(nd.op(k) - expect).evalf();
+		if (!is_a<numeric>(err) || ex_to<numeric>(err) > numeric(1, 1000000000)*(1+abs(ex_to<numeric>(expect)))) {
+			clog << "numeric derivative of order " << k << " of " << e << " at "
+			     << r << "==" << a << " returned " << nd.op(k) << " instead of "
+			     << expect << endl;
+			++result;
+		}
+		d = d.diff(r);
+	}
+
+	// powers with integer exponents are fine at zero
+	nd = numeric_derivatives(pow(sin(x), 3), x, 0, 3);
+	if (!(nd.op(3) - 6).is_zero() || !nd.op(2).is_zero()) {
+		clog << "numeric derivatives of sin(x)^3 at 0 returned " << nd << endl;
+		++result;
+	}
+
+	return result;
+}
+
 unsigned exam_differentiation()
 {
 	unsigned result = 0;
@@ -272,6 +445,9 @@ unsigned exam_differentiation()
 	result += exam_differentiation5();  cout << '.' << flush;
 	result += exam_differentiation6();  cout << '.' << flush;
 	result += exam_differentiation7();  cout << '.' << flush;
+	result += exam_differentiation8();  cout << '.' << flush;
+	result += exam_differentiation9();  cout << '.' << flush;
+	result += exam_differentiation10();  cout << '.' << flush;
 	
 	return result;
 }
@@ -54,5 +54,24 @@ int main(int argc, char** argv)
 		cerr << "gcd(" << a1 << ", " << b << ") was miscomputed" << endl;
 		return 1;
 	}
+
+	// cofactors of integer polynomials with negative leading coefficients
+	// and content, and a coprime pair
+	const ex d = 3*x - 2;
+	const ex f = expand(-6*d*(pow(x, 3) - x + 7));
+	const ex h = expand(4*d*d*(x + 1));
+	ex cf, ch;
+	ex g3 = gcd(f, h, &cf, &ch);
+	if (!expand(g3 - 2*d).is_zero() || !expand(g3*cf - f).is_zero() ||
+	    !expand(g3*ch - h).is_zero()) {
+		cerr << "gcd(" << f << ", " << h << ") was miscomputed: "
+		     << g3 << ", cofactors " << cf << ", " << ch << endl;
+		return 1;
+	}
+	ex g4 = gcd(expand(f*(x + 5)), expand(pow(x, 4) + 1), &cf, &ch);
+	if (g4 != _ex1) {
+		cerr << "gcd of coprime polynomials was miscomputed as " << g4 << endl;
+		return 1;
+	}
 	return 0;
 }
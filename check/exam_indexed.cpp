@@ -24,6 +24,7 @@
 using namespace GiNaC;
 
 #include <iostream>
+#include <string>
 using namespace std;
 
 static unsigned check_equal(const ex &e1, const ex &e2)
@@ -199,6 +200,24 @@ static unsigned symmetry_check()
 	e = (indexed(A, sy_anti(), i, j, k, l) * (indexed(B, j) * indexed(C, k) + indexed(B, k) * indexed(C, j)) + indexed(B, i, l)).expand();
 	result += check_equal_simplify(e, indexed(B, i, l));
 
+	// larger groups of symmetric indices
+	exvector iv;
+	for (unsigned n=0; n<8; ++n)
+		iv.push_back(idx(symbol("m" + std::to_string(n)), 8));
+	exvector rv(iv.rbegin(), iv.rend());
+	result += check_equal(indexed(A, sy_symm(), iv) - indexed(A, sy_symm(), rv), 0);
+	result += check_equal(indexed(A, sy_anti(), iv) - indexed(A, sy_anti(), rv), 0);
+	std::swap(rv[0], rv[1]);
+	result += check_equal(indexed(A, sy_anti(), iv) + indexed(A, sy_anti(), rv), 0);
+	rv[0] = rv[1];
+	result += check_equal(indexed(A, sy_anti(), rv), 0);
+	e = indexed(A, sy_symm(), iv);
+	result += check_equal(symmetrize(e), e);
+	result += check_equal(antisymmetrize(e), 0);
+	e = indexed(A, sy_anti(), iv);
+	result += check_equal(symmetrize(e), 0);
+	result += check_equal(antisymmetrize(e), e);
+
 	result += check_equal(symm_fcn(0, 1) + symm_fcn(1, 0), 2*symm_fcn(0, 1));
 	result += check_equal(anti_fcn(0, 1) + anti_fcn(1, 0), 0);
 	result += check_equal(anti_fcn(0, 0), 0);
@@ -226,6 +245,76 @@ static unsigned scalar_product_check()
 	e = indexed(A, i, i) * indexed(B, j, j); // GiNaC 0.8.0 had a bug here
 	result += check_equal_simplify(e, e, sp);
 
+	// dimension-specific scalar products take precedence over generic ones
+	symbol x("x"), y("y");
+	idx k(symbol("k"), 4);
+	sp.add(B, C, y);
+	sp.add(B, C, 4, x);
+	e = indexed(B, i) * indexed(C, i);
+	result += check_equal_simplify(e, y, sp);
+	e = indexed(B, k) * indexed(C, k);
+	result += check_equal_simplify(e, x, sp);
+
+	// many invariants, all replaced in one product
+	exvector p;
+	for (unsigned n=0; n<50; ++n)
+		p.push_back(symbol("p" + std::to_string(n)));
+	scalar_products sp2;
+	for (unsigned n=0; n<50; ++n)
+		for (unsigned m=n; m<50; ++m)
+			sp2.add(p[n], p[m], n * m + 1);
+	ex prod = 1, expected = 1;
+	for (unsigned n=0; n<50; n+=2) {
+		idx l(symbol("l" + std::to_string(n)), 3);
+		prod *= indexed(p[n], l) * indexed(p[n+1], l);
+		expected *= n * (n+1) + 1;
+	}
+	result += check_equal_simplify(prod, expected, sp2);
+
+	return result;
+}
+
+static unsigned check_components(const std::vector<numeric> &c, const lst &l)
+{
+	if (c.size() != l.nops()) {
+		clog << "wrong number of components: " << c.size() << " instead of " << l.nops() << endl;
+		return 1;
+	}
+	unsigned result = 0;
+	for (size_t n=0; n<c.size(); ++n)
+		result += check_equal(c[n], l.op(n));
+	return result;
+}
+
+static unsigned components_check()
+{
+	// check numeric evaluation of components
+
+	unsigned result = 0;
+
+	idx i(symbol("i"), 3), j(symbol("j"), 3), k(symbol("k"), 3);
+	matrix M = {{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+	matrix a = {{1, -1, 2}}, b = {{3, 0, 1}};
+	matrix M2 = M.mul(M);
+	std::vector<numeric> c;
+
+	c = eval_components(indexed(M, i, j) * indexed(a, j) + 2 * indexed(b, i), exvector{i});
+	result += check_components(c, lst{11, 11, 21});
+
+	c = eval_components(epsilon_tensor(i, j, k) * indexed(a, j) * indexed(b, k), exvector{i});
+	result += check_components(c, lst{-1, 5, 3});
+
+	c = eval_components(indexed(M, i, j) * indexed(M, j, k), exvector{k, i});
+	for (unsigned n=0; n<3; ++n)
+		for (unsigned m=0; m<3; ++m)
+			result += check_equal(c[3 * n + m], M2(m, n));
+
+	c = eval_components(delta_tensor(i, j) * indexed(M, j, k) * indexed(M, k, i), exvector{});
+	result += check_equal(c[0], M2.trace());
+
+	c = eval_components(pow(indexed(a, i), 2) * indexed(b, j), exvector{j});
+	result += check_components(c, lst{18, 0, 6});
+
 	return result;
 }
 
@@ -377,6 +466,29 @@ static unsigned dummy_check()
 	e = indexed(p, mu.toggle_variance(), mu) - indexed(p, nu, nu.toggle_variance());
 	result += check_equal_simplify(e, 0);
 
+	// canonical relabeling of dummy indices in products with symmetries
+	symbol A("A"), B("B"), C("C");
+	idx k(symbol("k"), 3), l(symbol("l"), 3);
+	e = indexed(A, sy_symm(), i, j) * indexed(B, sy_anti(), j, k) * indexed(C, k, i)
+	  - indexed(A, sy_symm(), k, i) * indexed(B, sy_anti(), k, j) * indexed(C, j, i);
+	result += check_equal_simplify(e, 0);
+	e = indexed(A, sy_symm(), i, j) * indexed(B, sy_anti(), j, k) * indexed(C, k, i)
+	  + indexed(A, sy_symm(), k, i) * indexed(B, sy_anti(), j, k) * indexed(C, j, i);
+	result += check_equal_simplify(e, 0);
+	symmetry R = sy_symm(sy_anti(0, 1), sy_anti(2, 3));
+	e = indexed(A, R, i, j, k, l) * indexed(A, R, i, k, j, l) * indexed(p, n)
+	  + indexed(A, R, j, k, l, i) * indexed(A, R, j, l, k, i) * indexed(p, n)
+	  - 2 * indexed(A, R, l, k, j, i) * indexed(A, R, j, l, i, k) * indexed(p, n);
+	result += check_equal_simplify(e, 0);
+
+	// many terms that only differ by dummy index names
+	e = -100 * indexed(A, sy_symm(), i, j) * indexed(p, i) * indexed(q, j);
+	for (int m=0; m<100; ++m) {
+		idx a(symbol("a" + std::to_string(m)), 3), b(symbol("b" + std::to_string(m)), 3);
+		e += indexed(A, sy_symm(), a, b) * indexed(p, (m % 2) ? a : b) * indexed(q, (m % 2) ? b : a);
+	}
+	result += check_equal_simplify(e, 0);
+
 	// GiNaC 1.2.1 had a bug here because p.i*p.i -> (p.i)^2
 	e = indexed(p, i) * indexed(p, i) * indexed(p, j) + indexed(p, j);
 	ex fi = exprseq(e.get_free_indices());
@@ -400,6 +512,7 @@ unsigned exam_indexed()
 	result += epsilon_check();  cout << '.' << flush;
 	result += symmetry_check();  cout << '.' << flush;
 	result += scalar_product_check();  cout << '.' << flush;
+	result += components_check();  cout << '.' << flush;
 	result += edyn_check();  cout << '.' << flush;
 	result += spinor_check(); cout << '.' << flush;
 	result += dummy_check(); cout << '.' << flush;
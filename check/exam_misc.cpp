@@ -296,6 +296,74 @@ static unsigned exam_exponent_power_law()
 	return result;
 }
 
+static unsigned exam_numeric_integral()
+{
+	unsigned result = 0;
+	symbol x("x");
+
+	// end point singularity
+	ex e = integral(x, 0, 1, exp(x)*sin(x) + 1/sqrt(x)).evalf();
+	ex exact = ((exp(ex(1))*(sin(ex(1)) - cos(ex(1))) + 1)/2 + 2).evalf();
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e - exact)) > 1e-8) {
+		clog << "integral of exp(x)*sin(x)+1/sqrt(x) from 0 to 1 returned "
+		     << e << " instead of " << exact << endl;
+		++result;
+	}
+
+	// functions with index lists
+	// H({1},x) = -log(1-x), G({1},x) = log(1-x)
+	e = integral(x, 0, numeric(1, 2), H(lst{1}, x) + 2*G(lst{1}, x)).evalf();
+	exact = (log(ex(2))/2 - numeric(1, 2)).evalf();
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e - exact)) > 1e-8) {
+		clog << "integral of H({1},x)+2*G({1},x) from 0 to 1/2 returned "
+		     << e << " instead of " << exact << endl;
+		++result;
+	}
+
+	// high precision for analytic integrands
+	long digits = Digits;
+	Digits = 40;
+	e = doubleexponential(x, 0, 1, 4/(1+pow(x, 2)), numeric(10).power(-30));
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e - Pi.evalf())) > numeric(1, 1000000000).power(3)) {
+		clog << "integral of 4/(1+x^2) from 0 to 1 returned " << e
+		     << " instead of " << Pi.evalf() << endl;
+		++result;
+	}
+	Digits = digits;
+
+	// nested integrals with variable boundaries
+	symbol y("y"), z("z");
+	e = integral(x, 0, 1, integral(y, 0, x, integral(z, 0, y, x*y*z))).evalf();
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e) - numeric(1, 48)) > 1e-8) {
+		clog << "nested integral of x*y*z returned " << e << " instead of 1/48" << endl;
+		++result;
+	}
+	e = integral(x, 0, 1, integral(y, 0, 1, exp(x+y))).evalf();
+	exact = pow(exp(ex(1)) - 1, 2).evalf();
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e - exact)) > 1e-7) {
+		clog << "nested integral of exp(x+y) returned " << e << " instead of "
+		     << exact << endl;
+		++result;
+	}
+
+	// many dimensions: lattice rule
+	exvector xs;
+	ex f = 0;
+	for (int i = 0; i < 8; ++i) {
+		xs.push_back(symbol());
+		f += xs.back();
+	}
+	for (auto & v : xs)
+		f = integral(v, 0, 1, f);
+	e = adaptivecubature(f, 1e-3);
+	if (!is_a<numeric>(e) || abs(ex_to<numeric>(e) - 4) > 1e-2) {
+		clog << "8-dimensional integral of x1+...+x8 returned " << e << " instead of 4" << endl;
+		++result;
+	}
+
+	return result;
+}
+
 unsigned exam_misc()
 {
 	unsigned result = 0;
@@ -308,6 +376,7 @@ unsigned exam_misc()
 	result += exam_operator_semantics(); cout << '.' << flush;
 	result += exam_subs(); cout << '.' << flush;
 	result += exam_joris(); cout << '.' << flush;
+	result += exam_numeric_integral(); cout << '.' << flush;
 	result += exam_subs_algebraic(); cout << '.' << flush;
 	result += exam_exponent_power_law(); cout << '.' << flush;
 	
@@ -29,6 +29,10 @@
 #include "polynomial/upoly.h"
 #include "polynomial/upoly_io.h"
 #include "polynomial/mod_gcd.h"
+#include "polynomial/half_gcd.h"
+#include "polynomial/multipoint.h"
+#include "polynomial/normalize.h"
+#include "polynomial/remainder.h"
 #include "ginac.h"
 using namespace GiNaC;
 
@@ -62,6 +66,44 @@ static void run_test_once(const std::size_t deg)
 	}
 }
 
+// make a univariate polynomial \in Z_p[x] of degree deg
+static umodpoly make_random_umodpoly(const std::size_t deg,
+				     const cln::cl_modint_ring& R);
+
+// Euclidean algorithm in Z_p[x], half_gcd() is checked against it
+static umodpoly euclid_gcd_mod_p(umodpoly a, umodpoly b)
+{
+	if (a.size() < b.size())
+		a.swap(b);
+	umodpoly r;
+	while (!b.empty()) {
+		remainder_in_field(r, a, b);
+		a.swap(b);
+		b.swap(r);
+	}
+	normalize_in_field(a);
+	return a;
+}
+
+static void run_half_gcd_test_once(const std::size_t deg)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(1000003);
+	const umodpoly c = make_random_umodpoly(deg/3, R);
+	const umodpoly a = poly_mul(c, make_random_umodpoly(deg - deg/3, R));
+	const umodpoly b = poly_mul(c, make_random_umodpoly(deg - deg/3 - 1, R));
+
+	umodpoly g;
+	half_gcd(g, a, b);
+	const umodpoly g_check = euclid_gcd_mod_p(a, b);
+	if (g != g_check || degree(g) < degree(c)) {
+		std::cerr << "a = " << a << std::endl;
+		std::cerr << "b = " << b << std::endl;
+		std::cerr << "half_gcd(a, b) = " << g << std::endl;
+		std::cerr << "Euclid(a, b) = " << g_check << std::endl;
+		throw std::logic_error("bug in half_gcd");
+	}
+}
+
 int main(int argc, char** argv)
 {
 	std::cout << "examining modular gcd. ";
@@ -75,6 +117,9 @@ int main(int argc, char** argv)
 		for (std::size_t k = 0; k < i->second; ++k)
 			run_test_once(i->first);
 	}
+	// half-GCD over Z_p, above and below its recursion threshold
+	for (std::size_t deg = 30; deg <= 1000; deg = 3*deg + 1)
+		run_half_gcd_test_once(deg);
 	return 0;
 }
 
@@ -106,3 +151,16 @@ static upoly make_random_upoly(const std::size_t deg)
 		p[deg] = cln::random_I(biggish);
 	return p;
 }
+
+static umodpoly make_random_umodpoly(const std::size_t deg,
+				     const cln::cl_modint_ring& R)
+{
+	umodpoly p(deg + 1);
+	for (std::size_t i = 0; i <= deg; ++i)
+		p[i] = R->random();
+
+	// Make sure the leading coefficient is non-zero
+	while (zerop(p[deg]))
+		p[deg] = R->random();
+	return p;
+}
@@ -330,6 +330,181 @@ static unsigned exam_power_law()
 	return result;
 }
 
+// Sums of many fractions with partly common denominators
+static unsigned exam_normal_sum()
+{
+	unsigned result = 0;
+	const int n = 40;
+	ex e = 0, prod = 1;
+	for (int i = 1; i <= n; ++i) {
+		e += numeric(i) / (x + i) + y / ((x + i) * (x + i + 1));
+		prod *= x + i;
+	}
+	prod *= x + n + 1;
+	// sum_i y/((x+i)(x+i+1)) telescopes to y/(x+1) - y/(x+n+1)
+	ex expected = y / (x + 1) - y / (x + n + 1);
+	for (int i = 1; i <= n; ++i)
+		expected += numeric(i) / (x + i);
+
+	ex en = e.normal();
+	if (!(en.numer() * expected.denom() - en.denom() * expected.numer()).expand().is_zero()) {
+		clog << "normal form of sum of " << 2*n << " fractions erroneously returned "
+		     << en << endl;
+		++result;
+	}
+	if (!normal(en.denom() / prod).info(info_flags::rational)
+	    || en.denom().degree(x) != n + 1) {
+		clog << "sum of " << 2*n << " fractions has denominator " << en.denom()
+		     << " (should be " << prod << " up to a constant)" << endl;
+		++result;
+	}
+	return result;
+}
+
+static unsigned check_ratfunc(const ratfunc & r, const ex & e)
+{
+	const ex d = (r.to_ex() - e).normal();
+	if (!d.is_zero()) {
+		clog << "ratfunc " << r << " erroneously differs from " << e
+		     << " by " << d << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Rational functions with factored denominators
+static unsigned exam_ratfunc()
+{
+	unsigned result = 0;
+	ratfunc a(x / (x*x - 1)), b(y / (x + 1)), c(1 / (x*x + 2*x + 1));
+
+	result += check_ratfunc(a + b, x / (x*x - 1) + y / (x + 1));
+	result += check_ratfunc(a * b / c, x * y * (x + 1) / (x - 1));
+	result += check_ratfunc(a - b * c, x / (x*x - 1) - y / pow(x + 1, 3));
+
+	// cancellation of whole and partial factors
+	if (!(b - b).is_zero()) {
+		clog << "ratfunc " << b << " minus itself is not zero" << endl;
+		++result;
+	}
+	ratfunc r = a * ratfunc(x + 1);
+	if (!(r.denom() - (x - 1)).expand().is_zero()) {
+		clog << "ratfunc " << r << " has denominator " << r.denom()
+		     << " (should be x-1)" << endl;
+		++result;
+	}
+	r = ratfunc(1 / ((x + 1) * (x - 1))) + ratfunc(1 / ((x + 1) * (x + 3)));
+	result += check_ratfunc(r, 2 / ((x - 1) * (x + 3)));
+	if (r.denom().degree(x) != 2) {
+		clog << "ratfunc " << r << " is not cancelled" << endl;
+		++result;
+	}
+
+	// the factors of the denominator are pairwise coprime
+	r = ratfunc(1 / (x*x - 1)) + ratfunc(1 / (x*x + 3*x + 2)) + ratfunc(1 / (x*x + x - 2));
+	const ratfunc::factor_vector & fv = r.denom_factors();
+	for (size_t i = 0; i < fv.size(); ++i)
+		for (size_t j = i + 1; j < fv.size(); ++j)
+			if (!is_a<numeric>(gcd(fv[i].first, fv[j].first))) {
+				clog << "ratfunc " << r << " has common factors "
+				     << fv[i].first << " and " << fv[j].first << endl;
+				++result;
+			}
+	result += check_ratfunc(r, 1 / (x*x - 1) + 1 / (x*x + 3*x + 2) + 1 / (x*x + x - 2));
+
+	// factors split off by cancellation are primitive with positive
+	// leading coefficient
+	r = ratfunc((3 - x) / (2*x*x - 2)) * ratfunc((2 - 2*x) / (x - 3))
+	    + ratfunc(1 / (4 - 2*x*x - 2*x));
+	for (auto & f : r.denom_factors()) {
+		if (!f.first.integer_content().is_equal(1) ||
+		    !ex_to<numeric>(f.first.lcoeff(x)).is_positive()) {
+			clog << "ratfunc " << r << " has the factor " << f.first
+			     << ", which is not primitive with positive leading coefficient" << endl;
+			++result;
+		}
+	}
+	result += check_ratfunc(r, 1 / (x + 1) - 1 / (2*(x - 1)*(x + 2)));
+
+	try {
+		r = b / ratfunc();
+		clog << "division of ratfunc by zero did not throw" << endl;
+		++result;
+	} catch (const std::overflow_error &) { }
+	try {
+		r = ratfunc(sin(x));
+		clog << "ratfunc from sin(x) did not throw" << endl;
+		++result;
+	} catch (const std::invalid_argument &) { }
+
+	return result;
+}
+
+static unsigned check_normal_by_interpolation(const ex & e)
+{
+	const ex en = normal_by_interpolation(e);
+	const ex d = e.normal();
+	if (!(en.numer() * d.denom() - en.denom() * d.numer()).expand().is_zero()
+	    || en.denom().degree(x) != d.denom().degree(x)) {
+		clog << "normal_by_interpolation(" << e << ") erroneously returned "
+		     << en << " (should be " << d << ")" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Normal form from values modulo primes
+static unsigned exam_normal_by_interpolation()
+{
+	unsigned result = 0;
+
+	result += check_normal_by_interpolation((x*x - 1) / (x - 1));
+	result += check_normal_by_interpolation(x / (x + y) + y / (x + y) - 1);
+	// the denominator vanishes at the origin
+	result += check_normal_by_interpolation((x*x - y*y) / (x*y*(x - y)) + 1/x
+	                                        + numeric(5, 2) * y / (z*z + 3*x + 1));
+	result += check_normal_by_interpolation(pow(x + 2*y - z, 4) / pow(x*x - 4*y*y, 2)
+	                                        - w / (x - 2*y));
+	result += check_normal_by_interpolation((pow(sin(x), 2) + 2*sin(x) + 1) / (sin(x) + 1));
+
+	ex e = 0;
+	for (int i = 1; i <= 10; ++i)
+		e += pow(y, i) / (x + i) - numeric(1, i) / (x*y + i);
+	result += check_normal_by_interpolation(e);
+
+	// a denominator that vanishes identically without being simplified
+	try {
+		e = normal_by_interpolation(1 / (pow(x + 1, 2) - x*x - 2*x - 1));
+		clog << "normal_by_interpolation() of a fraction with zero denominator "
+		     << "did not throw but returned " << e << endl;
+		++result;
+	} catch (const pole_error &) { }
+
+	return result;
+}
+
+// Many non-rational atoms whose replacement symbols get redefined
+static unsigned exam_normal_atoms()
+{
+	unsigned result = 0;
+	ex e = 0;
+	for (int i = 1; i <= 6; ++i)
+		e += (sqrt(x + i) + pow(x + i, numeric(1, 4))) / (pow(x + i, numeric(3, 4)) - 1)
+		     + exp(i*x/2) * exp(x/3) / (exp(x/6) + i);
+	e += pow(x, numeric(1, 2)) / (pow(x, numeric(1, 3)) + 1);
+	const ex en = e.normal();
+	for (int k = 2; k <= 3; ++k) {
+		const exmap m = {{x, numeric(k, 7)}};
+		const ex d = (e.subs(m) - en.subs(m)).evalf();
+		if (abs(ex_to<numeric>(d)) > 1e-10) {
+			clog << "normal form of " << e << " erroneously returned " << en
+			     << " (differs by " << d << " at x=" << numeric(k, 7) << ")" << endl;
+			++result;
+		}
+	}
+	return result;
+}
+
 unsigned exam_normalization()
 {
 	unsigned result = 0;
@@ -340,6 +515,10 @@ unsigned exam_normalization()
 	result += exam_normal2(); cout << '.' << flush;
 	result += exam_normal3(); cout << '.' << flush;
 	result += exam_normal4(); cout << '.' << flush;
+	result += exam_normal_sum(); cout << '.' << flush;
+	result += exam_ratfunc(); cout << '.' << flush;
+	result += exam_normal_by_interpolation(); cout << '.' << flush;
+	result += exam_normal_atoms(); cout << '.' << flush;
 	result += exam_content(); cout << '.' << flush;
 	result += exam_exponent_law(); cout << '.' << flush;
 	result += exam_power_law(); cout << '.' << flush;
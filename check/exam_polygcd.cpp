@@ -230,6 +230,88 @@ static unsigned poly_gcd7()
 	return 0;
 }
 
+// Rational coefficients and repeated queries on the same polynomials
+static unsigned poly_gcd8()
+{
+	symbol y("y");
+	ex d = x*y/3 + z/2 - 1;
+
+	for (int j=1; j<=MAX_VARIABLES; j++) {
+		ex f = (d * (pow(x, j) - y/5 + 2)).expand();
+		ex g = (d * (pow(z, j) + x*y*7/4)).expand();
+		ex r1 = gcd(f, g);
+		ex r2 = gcd(f, g);
+		if (!(r1 - r2).expand().is_zero()) {
+			clog << "case 8, gcd(" << f << "," << g << ") returned " << r1
+			     << " and then " << r2 << endl;
+			return 1;
+		}
+		if (!normal(r1 / d).info(info_flags::rational)) {
+			clog << "case 8, gcd(" << f << "," << g << ") = " << r1 << " (should be " << d << " up to a unit)" << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Interpolation from samples
+static unsigned poly_interpolation()
+{
+	ex p = 0;
+	for (int i=0; i<=20; i++)
+		p += numeric(i*i - 7, i + 1) * pow(x, i);
+	lst points, values;
+	for (int i=0; i<=20; i++) {
+		const numeric pt = numeric(i - 10, 3);
+		points.append(pt);
+		values.append(p.subs(x == pt));
+	}
+	ex r = interpolation_polynomial(points, values, x);
+	if (!(r - p).expand().is_zero()) {
+		clog << "interpolation_polynomial(" << points << "," << values << ") = " << r << " (should be " << p << ")" << endl;
+		return 1;
+	}
+
+	try {
+		interpolation_polynomial(lst{1, 2, 1}, lst{3, 4, 5}, x);
+		clog << "interpolation_polynomial() with repeated points did not throw" << endl;
+		return 1;
+	} catch (const std::invalid_argument &) {
+	}
+	return 0;
+}
+
+// Resultants of bivariate polynomials (computed by interpolation)
+static unsigned poly_resultant()
+{
+	symbol y("y");
+	unsigned result = 0;
+
+	ex e1 = x + pow(y, 2), e2 = 2*pow(x, 3) - 1;
+	ex r = resultant(e1, e2, x);
+	if (!(r - (1 + 2*pow(y, 6))).expand().is_zero()) {
+		clog << "resultant(" << e1 << "," << e2 << ",x) = " << r << " (should be 1+2*y^6)" << endl;
+		++result;
+	}
+	r = resultant(e1, e2, y);
+	if (!(r - (1 - 4*pow(x, 3) + 4*pow(x, 6))).expand().is_zero()) {
+		clog << "resultant(" << e1 << "," << e2 << ",y) = " << r << " (should be 1-4*x^3+4*x^6)" << endl;
+		++result;
+	}
+
+	// res(f, g*h) = res(f, g) res(f, h)
+	ex f = pow(x, 3) - 2*x*y + pow(y, 2)/3 - 1;
+	ex g = pow(x, 2)*y - x + pow(y, 3);
+	ex h = 3*pow(x, 4) + 5*pow(y, 2)*x - y + 7;
+	ex rgh = resultant(f, (g*h).expand(), x);
+	ex rg_rh = resultant(f, g, x) * resultant(f, h, x);
+	if (!(rgh - rg_rh).expand().is_zero()) {
+		clog << "resultant(" << f << "," << (g*h).expand() << ",x) = " << rgh << " (should be " << rg_rh.expand() << ")" << endl;
+		++result;
+	}
+	return result;
+}
+
 unsigned exam_polygcd()
 {
 	unsigned result = 0;
@@ -245,6 +327,9 @@ unsigned exam_polygcd()
 	result += poly_gcd5p();  cout << '.' << flush;
 	result += poly_gcd6();  cout << '.' << flush;
 	result += poly_gcd7();  cout << '.' << flush;
+	result += poly_gcd8();  cout << '.' << flush;
+	result += poly_interpolation();  cout << '.' << flush;
+	result += poly_resultant();  cout << '.' << flush;
 	
 	return result;
 }
@@ -232,12 +232,60 @@ unsigned exam_sqrfree_parfrac()
 	return result;
 }
 
+unsigned exam_parfrac()
+{
+	symbol x("x"), y("y");
+	unsigned result = 0;
+
+	cout << "\n"
+	     << "examining partial fraction decomposition" << flush;
+
+	// the factors of the denominator are kept apart
+	vector<pair<ex, unsigned>> exams = {
+		{ex("(x - 1) / (x^2*(x^2 + 2))", lst{x}), 3},
+		{ex("x^5 / ((x - 1)^3 * (x + 2)^2)", lst{x}), 6},
+		{ex("(x + y) / ((x - y)^2 * (x + 1) * (x^2 + y))", lst{x, y}), 4},
+		{ex("1/(x - 1) + y/((x + 1)*(x - y)) - 1/(x + 1)", lst{x, y}), 3}
+	};
+	for (auto e: exams) {
+		ex e1 = e.first;
+		ex e2 = parfrac(e1, x);
+		if (e2.nops() != e.second ||
+		    !is_a<add>(e2) ||
+		    !normal(e1-e2).is_zero()) {
+			clog << "parfrac(" << e1 << ", " << x << ") erroneously returned "
+			     << e2 << endl;
+			++result;
+		}
+		cout << '.' << flush;
+	}
+
+	// many distinct linear factors
+	const int n = 60;
+	exvector factors;
+	for (int i = 1; i <= n; ++i)
+		factors.push_back(pow(x + i, -1));
+	ex e1 = (pow(x, 3) + 2) * mul(factors);
+	ex e2 = parfrac(e1, x);
+	const ex x0 = numeric(1, 3);
+	if (e2.nops() != n || e1.subs(x == x0) != e2.subs(x == x0)) {
+		clog << "parfrac() of a fraction with " << n
+		     << " linear factors in the denominator erroneously returned "
+		     << e2 << endl;
+		++result;
+	}
+	cout << '.' << flush;
+
+	return result;
+}
+
 int main(int argc, char** argv)
 {
 	unsigned result = 0;
 
 	result += exam_sqrfree();
 	result += exam_sqrfree_parfrac();
+	result += exam_parfrac();
 
 	return result;
 }
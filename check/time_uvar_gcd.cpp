@@ -27,6 +27,9 @@
 #include "polynomial/remainder.h"
 #include "polynomial/upoly.h"
 #include "polynomial/mod_gcd.h"
+#include "polynomial/half_gcd.h"
+#include "polynomial/multipoint.h"
+#include "polynomial/normalize.h"
 using namespace GiNaC;
 
 #include <string>
@@ -1862,6 +1865,80 @@ run_test(const std::string& s1, const std::string& s2,
 	}
 }
 
+/// Classical Euclidean algorithm in Z_p[x] (gcd_euclid() switches to the
+/// half-GCD algorithm for large degrees)
+static void euclid_gcd_mod_p(umodpoly& g, const umodpoly& a, const umodpoly& b)
+{
+	umodpoly c = a, d = b;
+	if (c.size() < d.size())
+		c.swap(d);
+	umodpoly r;
+	while (!d.empty()) {
+		remainder_in_field(r, c, d);
+		c.swap(d);
+		d.swap(r);
+	}
+	normalize_in_field(c);
+	g.swap(c);
+}
+
+struct modp_gcd_test
+{
+	const umodpoly& a, b;
+	umodpoly g;
+	const bool use_half_gcd;
+
+	inline void run()
+	{
+		if (use_half_gcd)
+			half_gcd(g, a, b);
+		else
+			euclid_gcd_mod_p(g, a, b);
+	}
+
+	bool check() const
+	{
+		return true;
+	}
+
+	void print_result(const double t) const
+	{
+		std::streamsize display_digits = std::cout.precision(2);
+		std::cout << std::scientific;
+		std::cout << (use_half_gcd ? "half_gcd" : "euclid") << "\t\t: "
+			  << g.size() << " " << t << std::endl;
+		std::cout.precision(display_digits);
+	}
+
+	modp_gcd_test(const umodpoly& a_, const umodpoly& b_, const bool hgcd) :
+		a(a_), b(b_), use_half_gcd(hgcd)
+	{ }
+};
+
+static umodpoly make_random_umodpoly(const std::size_t deg,
+				     const cln::cl_modint_ring& R);
+// GCDs of polynomials of growing degree over Z_p with a common factor of
+// half their degree, by the Euclidean and the half-GCD algorithm. The
+// crossover gives half_gcd_threshold.
+static void run_modp_tests(const std::size_t max_deg)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(2147483647);
+	for (std::size_t d = 32; d <= max_deg; d *= 2) {
+		std::cout << "GCD in Z_p[x], degree(a) = degree(b) = " << d
+			  << ", half_gcd_threshold = " << half_gcd_threshold
+			  << std::endl << std::flush;
+		const umodpoly c = make_random_umodpoly(d/2, R);
+		const umodpoly a = poly_mul(c, make_random_umodpoly(d - d/2, R));
+		const umodpoly b = poly_mul(c, make_random_umodpoly(d - d/2, R));
+		modp_gcd_test b_euclid(a, b, false);
+		run_benchmark(b_euclid);
+		modp_gcd_test b_half_gcd(a, b, true);
+		run_benchmark(b_half_gcd);
+		cbug_on(b_euclid.g != b_half_gcd.g, "half_gcd and Euclid disagree: " <<
+			"a = \"" << a << "\", b = \"" << b << "\"");
+	}
+}
+
 static upoly make_random_upoly(const std::size_t deg);
 // Make random polynomials, most likely they will be relatively prime.
 // Check how different algorithms behave on such inputs.
@@ -1893,10 +1970,22 @@ int main(int argc, char** argv)
 	run_test(q1_srep_1 + q1_srep_2, q2_srep_1 + q2_srep_2, tolerant_p, masochist_p);
 	// ditto
 	run_test(r1_srep_1 + r1_srep_2 + r1_srep_3, r2_srep_1 + r2_srep_2 + r2_srep_3, masochist_p, masochist_p);
+	run_modp_tests(tolerant_p ? 8192 : 2048);
 	std::cout << ". " << std::flush;
 	return 0;
 }
 
+static umodpoly make_random_umodpoly(const std::size_t deg,
+				     const cln::cl_modint_ring& R)
+{
+	umodpoly p(deg + 1);
+	for (std::size_t i = 0; i <= deg; ++i)
+		p[i] = R->random();
+	while (zerop(p[deg]))
+		p[deg] = R->random();
+	return p;
+}
+
 static upoly make_random_upoly(const std::size_t deg)
 {
 	static const cln::cl_I biggish("987654321098765432109876543210");
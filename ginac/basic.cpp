@@ -23,6 +23,7 @@
 #include "basic.h"
 #include "ex.h"
 #include "numeric.h"
+#include "mul.h"
 #include "power.h"
 #include "add.h"
 #include "symbol.h"
@@ -35,8 +36,12 @@
 #include "utils.h"
 #include "hash_seed.h"
 #include "inifcns.h"
+#include "gradient.h"
+#include "polynomial/collect_vargs.h"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <stdexcept>
 #include <typeinfo>
 
@@ -342,6 +347,66 @@ ex basic::coeff(const ex & s, int n) const
 		return n==0 ? *this : _ex0;
 }
 
+/** Check whether the object s can be collected by splitting the terms of a
+ *  sum into powers of s and s-free factors (see split_monomial()). */
+static bool is_collectable_object(const ex & s)
+{
+	return !is_a<numeric>(s) && !is_a<add>(s) && !is_a<mul>(s) &&
+	       !is_a<power>(s) && !is_a<ncmul>(s) && !is_a<lst>(s);
+}
+
+typedef std::map<exp_vector_t, exvector> monomial_buckets;
+
+/** Sum up the terms of a sum whose exponent vectors lie in [b, e), in
+ *  recursive form with respect to the objects vars[d], vars[d+1], ... */
+static ex assemble_recursive(const std::vector<std::pair<exp_vector_t, ex>> & v,
+                             size_t b, size_t e, const exvector & vars, size_t d)
+{
+	exvector terms;
+	while (b < e) {
+		const int n = v[b].first[d];
+		size_t m = b + 1;
+		while (m < e && v[m].first[d] == n)
+			++m;
+		ex c = (d + 1 == vars.size()) ? v[b].second : assemble_recursive(v, b, m, vars, d + 1);
+		terms.push_back(c * power(vars[d], n));
+		b = m;
+	}
+	return dynallocate<add>(terms);
+}
+
+/** Collect a sum whose terms are all monomials in the objects vars in a
+ *  single pass, producing the same recursive form as repeated collecting
+ *  in vars[n-1], ..., vars[0]. Returns false if some term does not have
+ *  that shape. */
+static bool collect_monomials(const basic & e, const exvector & vars, ex & result)
+{
+	if (!is_exactly_a<add>(e))
+		return false;
+	for (auto & v : vars) {
+		if (!is_collectable_object(v))
+			return false;
+	}
+
+	monomial_buckets buckets;
+	exp_vector_t exps(vars.size());
+	for (size_t i = 0; i < e.nops(); ++i) {
+		ex c;
+		if (!split_monomial(e.op(i), vars, exps, c))
+			return false;
+		buckets[exps].push_back(c);
+	}
+
+	// std::map iterates in lexicographic order, so terms sharing a power
+	// of the leading objects end up in consecutive ranges
+	std::vector<std::pair<exp_vector_t, ex>> v;
+	v.reserve(buckets.size());
+	for (auto & b : buckets)
+		v.push_back(std::make_pair(b.first, ex(dynallocate<add>(b.second))));
+	result = assemble_recursive(v, 0, v.size(), vars, 0);
+	return true;
+}
+
 /** Sort expanded expression in terms of powers of some object(s).
  *  @param s object(s) to sort in
  *  @param distributed recursive or distributed form (only used when s is a list) */
@@ -361,33 +426,42 @@ ex basic::collect(const ex & s, bool distributed) const
 			x = this->expand();
 			if (! is_a<add>(x))
 				return x; 
-			const lst& l(ex_to<lst>(s));
+			const exvector l(s.begin(), s.end());
 
-			exmap cmap;
-			cmap[_ex1] = _ex0;
+			// Bucket the coefficients by exponent vector and sum each
+			// bucket only once
+			const bool splittable = std::all_of(l.begin(), l.end(), is_collectable_object);
+			monomial_buckets cmap;
+			exp_vector_t key(l.size());
 			for (const auto & xi : x) {
-				ex key = _ex1;
-				ex pre_coeff = xi;
-				for (auto & li : l) {
-					int cexp = pre_coeff.degree(li);
-					pre_coeff = pre_coeff.coeff(li, cexp);
-					key *= pow(li, cexp);
+				ex pre_coeff;
+				if (!splittable || !split_monomial(xi, l, key, pre_coeff)) {
+					pre_coeff = xi;
+					for (size_t i = 0; i < l.size(); ++i) {
+						key[i] = pre_coeff.degree(l[i]);
+						pre_coeff = pre_coeff.coeff(l[i], key[i]);
+					}
 				}
-				auto ci = cmap.find(key);
-				if (ci != cmap.end())
-					ci->second += pre_coeff;
-				else
-					cmap.insert(exmap::value_type(key, pre_coeff));
+				cmap[key].push_back(pre_coeff);
 			}
 
 			exvector resv;
-			for (auto & mi : cmap)
-				resv.push_back((mi.first)*(mi.second));
+			resv.reserve(cmap.size());
+			for (auto & mi : cmap) {
+				exvector tv;
+				tv.reserve(l.size() + 1);
+				for (size_t i = 0; i < l.size(); ++i)
+					tv.push_back(pow(l[i], mi.first[i]));
+				tv.push_back(dynallocate<add>(mi.second));
+				resv.push_back(dynallocate<mul>(tv));
+			}
 			return dynallocate<add>(resv);
 
 		} else {
 
 			// Recursive form
+			if (collect_monomials(*this, exvector(s.begin(), s.end()), x))
+				return x;
 			x = *this;
 			size_t n = s.nops() - 1;
 			while (true) {
@@ -401,6 +475,8 @@ ex basic::collect(const ex & s, bool distributed) const
 	} else {
 
 		// Only one object specified
+		if (collect_monomials(*this, exvector{s}, x))
+			return x;
 		for (int n=this->ldegree(s); n<=this->degree(s); ++n)
 			x += this->coeff(s,n)*power(s,n);
 	}
@@ -637,8 +713,8 @@ ex basic::subs(const exmap & m, unsigned options) const
 }
 
 /** Default interface of nth derivative ex::diff(s, n).  It should be called
- *  instead of ::derivative(s) for first derivatives and for nth derivatives it
- *  just recurses down.
+ *  instead of ::derivative(s) for first derivatives.  Second derivatives
+ *  recurse down, higher ones are computed by derivatives().
  *
  *  @param s symbol to differentiate in
  *  @param nth order of differentiation
@@ -653,12 +729,14 @@ ex basic::diff(const symbol & s, unsigned nth) const
 	if (!(flags & status_flags::evaluated))
 		return ex(*this).diff(s, nth);
 	
+	// higher orders: compute all orders of all subexpressions at once
+	// instead of differentiating the growing previous result again
+	if (nth>2)
+		return derivatives(ex(*this), s, nth).op(nth);
+
 	ex ndiff = this->derivative(s);
-	while (!ndiff.is_zero() &&    // stop differentiating zeros
-	       nth>1) {
+	if (nth>1 && !ndiff.is_zero())    // stop differentiating zeros
 		ndiff = ndiff.diff(s);
-		--nth;
-	}
 	return ndiff;
 }
 
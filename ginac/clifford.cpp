@@ -38,6 +38,8 @@
 #include "archive.h"
 #include "utils.h"
 
+#include <bitset>
+#include <map>
 #include <stdexcept>
 
 namespace GiNaC {
@@ -1198,9 +1200,280 @@ int clifford_max_label(const ex & e, bool ignore_ONE)
 	}
 }
 
+/** Multivector of a Clifford algebra, stored as a map from basis blades to
+ *  their coefficients. A basis blade is an ordered product of distinct
+ *  Clifford units, encoded as a bitmask of their (numeric) indices. */
+typedef std::map<unsigned, ex> blade_map;
+
+static bool has_clifford(const ex & e)
+{
+	if (is_a<clifford>(e))
+		return true;
+	for (size_t i=0; i<e.nops(); ++i)
+		if (has_clifford(e.op(i)))
+			return true;
+	return false;
+}
+
+static bool has_indexed(const ex & e)
+{
+	if (is_a<indexed>(e))
+		return true;
+	for (size_t i=0; i<e.nops(); ++i)
+		if (has_indexed(e.op(i)))
+			return true;
+	return false;
+}
+
+/** Clifford algebra whose metric has a diagonal symmetric part, in which the
+ *  product of two basis blades is again a basis blade (given by the XOR of
+ *  the bitmasks) times a sign and the squares of the common units. The
+ *  algebra is set up from the first Clifford unit encountered. */
+class blade_algebra {
+public:
+	blade_algebra() : dim(0), label(-1), have_unit(false) {}
+
+	/** Convert an expression to a multivector. Returns false if the
+	 *  expression contains anything but units of a single algebra of this
+	 *  kind with numeric indices. */
+	bool convert(const ex & e, blade_map & r);
+
+	/** Multiply two multivectors. */
+	void multiply(const blade_map & a, const blade_map & b, blade_map & r) const;
+
+	/** Expand the coefficients and remove the vanishing ones. */
+	static void normalize(blade_map & m);
+
+	/** Convert a multivector back to products of Clifford units. */
+	ex to_ex(const blade_map & m) const;
+
+private:
+	bool set_label(unsigned char rl);
+	bool add_unit(const clifford & c);
+	ex make_index(unsigned k) const;
+	int reordering_sign(unsigned a, unsigned b) const;
+	static int count_reordering_sign(unsigned a, unsigned b);
+
+	unsigned dim;
+	int label;
+	bool have_unit;
+	ex unit;          /**< Some unit of the algebra, used as a template */
+	exvector squares; /**< Squares of the units */
+	std::vector<signed char> sign_table; /**< Signs of blade products (small algebras only) */
+
+	static const unsigned max_dim = 32;
+	static const unsigned max_table_dim = 6;
+};
+
+bool blade_algebra::set_label(unsigned char rl)
+{
+	if (label < 0)
+		label = rl;
+	return label == rl;
+}
+
+ex blade_algebra::make_index(unsigned k) const
+{
+	const ex & mu = unit.op(1);
+	if (is_a<varidx>(mu))
+		return varidx(k, ex_to<idx>(mu).get_dim());
+	return idx(k, ex_to<idx>(mu).get_dim());
+}
+
+bool blade_algebra::add_unit(const clifford & c)
+{
+	if (!set_label(c.get_representation_label()) || c.get_commutator_sign() != -1)
+		return false;
+
+	if (have_unit) {
+		const clifford & u = ex_to<clifford>(unit);
+		return c.get_metric().is_equal(u.get_metric()) || u.same_metric(c);
+	}
+
+	const ex & d = ex_to<idx>(c.op(1)).get_dim();
+	if (!d.info(info_flags::posint) || unsigned(ex_to<numeric>(d).to_int()) > max_dim)
+		return false;
+	unit = c;
+	dim = ex_to<numeric>(d).to_int();
+
+	// The symmetrised metric must be diagonal
+	exvector indices;
+	for (unsigned k=0; k<dim; ++k)
+		indices.push_back(make_index(k));
+	squares.clear();
+	for (unsigned i=0; i<dim; ++i) {
+		for (unsigned j=i; j<dim; ++j) {
+			ex g = c.get_metric(indices[i], indices[j]);
+			if (has_indexed(g))
+				return false;
+			if (i == j)
+				squares.push_back(g);
+			else if (!(g + c.get_metric(indices[j], indices[i])).is_zero())
+				return false;
+		}
+	}
+
+	if (dim <= max_table_dim) {
+		unsigned n = 1 << dim;
+		std::vector<signed char> table(n * n);
+		for (unsigned a=0; a<n; ++a)
+			for (unsigned b=0; b<n; ++b)
+				table[a * n + b] = count_reordering_sign(a, b);
+		sign_table = std::move(table);
+	}
+	have_unit = true;
+	return true;
+}
+
+/** Sign from moving all units of blade b past those units of blade a with a
+ *  larger index. */
+int blade_algebra::reordering_sign(unsigned a, unsigned b) const
+{
+	if (!sign_table.empty())
+		return sign_table[(a << dim) + b];
+	return count_reordering_sign(a, b);
+}
+
+int blade_algebra::count_reordering_sign(unsigned a, unsigned b)
+{
+	size_t swaps = 0;
+	for (a >>= 1; a; a >>= 1)
+		swaps += std::bitset<max_dim>(a & b).count();
+	return swaps % 2 ? -1 : 1;
+}
+
+bool blade_algebra::convert(const ex & e, blade_map & r)
+{
+	r.clear();
+	if (is_a<clifford>(e)) {
+		const clifford & c = ex_to<clifford>(e);
+		if (is_a<diracone>(e.op(0))) {
+			if (!set_label(c.get_representation_label()))
+				return false;
+			r[0] = _ex1;
+			return true;
+		}
+		if (!is_exactly_a<cliffordunit>(e.op(0)) || !add_unit(c))
+			return false;
+		const ex & mu = e.op(1);
+		if (is_a<varidx>(mu) && ex_to<varidx>(mu).is_covariant())
+			return false;
+		const ex & value = ex_to<idx>(mu).get_value();
+		if (!value.info(info_flags::nonnegint) || unsigned(ex_to<numeric>(value).to_int()) >= dim)
+			return false;
+		r[1u << ex_to<numeric>(value).to_int()] = _ex1;
+	} else if (!has_clifford(e)) {
+		r[0] = e;
+	} else if (is_exactly_a<add>(e)) {
+		for (size_t i=0; i<e.nops(); ++i) {
+			blade_map t;
+			if (!convert(e.op(i), t))
+				return false;
+			for (auto & it : t)
+				r[it.first] += it.second;
+		}
+	} else if (is_exactly_a<mul>(e) || is_exactly_a<ncmul>(e)) {
+		r[0] = _ex1;
+		for (size_t i=0; i<e.nops(); ++i) {
+			blade_map t, p;
+			if (!convert(e.op(i), t))
+				return false;
+			multiply(r, t, p);
+			r.swap(p);
+		}
+	} else if (is_exactly_a<power>(e) && e.op(1).info(info_flags::nonnegint)) {
+		blade_map b;
+		if (!convert(e.op(0), b))
+			return false;
+		r[0] = _ex1;
+		for (int n=ex_to<numeric>(e.op(1)).to_int(); n>0; --n) {
+			blade_map p;
+			multiply(r, b, p);
+			r.swap(p);
+		}
+	} else
+		return false;
+	return true;
+}
+
+void blade_algebra::multiply(const blade_map & a, const blade_map & b, blade_map & r) const
+{
+	r.clear();
+	for (auto & x : a) {
+		for (auto & y : b) {
+			ex factor = reordering_sign(x.first, y.first);
+			for (unsigned common = x.first & y.first, k = 0; common; common >>= 1, ++k)
+				if (common & 1)
+					factor *= squares[k];
+			if (!factor.is_zero())
+				r[x.first ^ y.first] += factor * x.second * y.second;
+		}
+	}
+}
+
+void blade_algebra::normalize(blade_map & m)
+{
+	for (auto it = m.begin(); it != m.end(); ) {
+		it->second = it->second.expand();
+		if (it->second.is_zero())
+			it = m.erase(it);
+		else
+			++it;
+	}
+}
+
+ex blade_algebra::to_ex(const blade_map & m) const
+{
+	exvector terms;
+	for (auto & it : m) {
+		ex c = it.second.expand();
+		if (c.is_zero())
+			continue;
+		if (it.first == 0) {
+			terms.push_back(label < 0 ? c : c * dirac_ONE(label));
+			continue;
+		}
+		const clifford & u = ex_to<clifford>(unit);
+		exvector units;
+		for (unsigned blade = it.first, k = 0; blade; blade >>= 1, ++k)
+			if (blade & 1)
+				units.push_back(clifford(u.op(0), make_index(k), u.get_metric(), label, -1));
+		terms.push_back(c * (units.size() == 1 ? units[0] : ncmul(std::move(units))));
+	}
+	return dynallocate<add>(terms);
+}
+
+ex clifford_blade_form(const ex & e)
+{
+	pointer_to_map_function fcn(clifford_blade_form);
+	if (is_a<matrix>(e) || e.info(info_flags::list))
+		return e.map(fcn);
+
+	blade_algebra alg;
+	blade_map m;
+	if (alg.convert(e, m))
+		return alg.to_ex(m);
+	return canonicalize_clifford(e);
+}
+
 ex clifford_norm(const ex & e)
 {
-	return sqrt(remove_dirac_ONE(e * clifford_bar(e)));
+	ex e_bar = clifford_bar(e);
+
+	// Clifford numbers in an algebra with diagonal metric are multiplied
+	// in the blade representation
+	blade_algebra alg;
+	blade_map a, b, p;
+	if (alg.convert(e, a) && alg.convert(e_bar, b)) {
+		alg.multiply(a, b, p);
+		alg.normalize(p);
+		if (p.empty())
+			return 0;
+		if (p.size() == 1 && p.begin()->first == 0)
+			return sqrt(p.begin()->second);
+	}
+
+	return sqrt(remove_dirac_ONE(e * e_bar));
 }
 	
 ex clifford_inverse(const ex & e)
@@ -278,6 +278,14 @@ ex dirac_trace(const ex & e, unsigned char rl = 0, const ex & trONE = 4);
  *  to check two expressions for equality. */
 ex canonicalize_clifford(const ex & e);
 
+/** Multiply out all products of Clifford units, using a representation of
+ *  Clifford numbers as maps from basis blades (bitmasks of the units in an
+ *  ordered product) to coefficients. This requires units with numeric
+ *  indices and a metric whose symmetrised form is diagonal with known
+ *  components. The result is a sum of ordered products of distinct units.
+ *  Other expressions are passed to canonicalize_clifford(). */
+ex clifford_blade_form(const ex & e);
+
 /** Automorphism of the Clifford algebra, simply changes signs of all
  *  clifford units. */
 ex clifford_prime(const ex & e);
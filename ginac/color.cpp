@@ -34,6 +34,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 namespace GiNaC {
 
@@ -218,6 +219,58 @@ static ex permute_free_index_to_front(const exvector & iv3, const exvector & iv2
 	throw(std::logic_error("permute_free_index_to_front(): no valid permutation found"));
 }
 
+/** Index of a sorted triple of index values 1..8 in the tables of structure
+ *  constants. */
+static inline unsigned su3_table_index(const int v[3])
+{
+	return (v[0] * 9 + v[1]) * 9 + v[2];
+}
+
+/** Table of the symmetric structure constants d_abc, indexed by sorted
+ *  index triples. */
+static const exvector & su3d_table()
+{
+	static exvector table;
+	if (table.empty()) {
+		table.assign(9 * 9 * 9, _ex0);
+		struct { int a, b, c; ex value; } entries[] = {
+			{1, 4, 6, _ex1_2}, {1, 5, 7, _ex1_2}, {2, 5, 6, _ex1_2},
+			{3, 4, 4, _ex1_2}, {3, 5, 5, _ex1_2},
+			{2, 4, 7, _ex_1_2}, {3, 6, 6, _ex_1_2}, {3, 7, 7, _ex_1_2},
+			{1, 1, 8, sqrt(_ex3)*_ex1_3}, {2, 2, 8, sqrt(_ex3)*_ex1_3}, {3, 3, 8, sqrt(_ex3)*_ex1_3},
+			{8, 8, 8, sqrt(_ex3)*_ex_1_3},
+			{4, 4, 8, sqrt(_ex3)/_ex_6}, {5, 5, 8, sqrt(_ex3)/_ex_6},
+			{6, 6, 8, sqrt(_ex3)/_ex_6}, {7, 7, 8, sqrt(_ex3)/_ex_6}
+		};
+		for (auto & e : entries) {
+			int v[3] = {e.a, e.b, e.c};
+			table[su3_table_index(v)] = e.value;
+		}
+	}
+	return table;
+}
+
+/** Table of the antisymmetric structure constants f_abc, indexed by sorted
+ *  index triples. */
+static const exvector & su3f_table()
+{
+	static exvector table;
+	if (table.empty()) {
+		table.assign(9 * 9 * 9, _ex0);
+		struct { int a, b, c; ex value; } entries[] = {
+			{1, 2, 3, _ex1},
+			{1, 4, 7, _ex1_2}, {2, 4, 6, _ex1_2}, {2, 5, 7, _ex1_2}, {3, 4, 5, _ex1_2},
+			{1, 5, 6, _ex_1_2}, {3, 6, 7, _ex_1_2},
+			{4, 5, 8, sqrt(_ex3)/2}, {6, 7, 8, sqrt(_ex3)/2}
+		};
+		for (auto & e : entries) {
+			int v[3] = {e.a, e.b, e.c};
+			table[su3_table_index(v)] = e.value;
+		}
+	}
+	return table;
+}
+
 /** Automatic symbolic evaluation of indexed symmetric structure constant. */
 ex su3d::eval_indexed(const basic & i) const
 {
@@ -240,23 +293,10 @@ ex su3d::eval_indexed(const basic & i) const
 		if (v[0] > v[2]) std::swap(v[0], v[2]);
 		if (v[1] > v[2]) std::swap(v[1], v[2]);
 
-#define CMPINDICES(A,B,C) ((v[0] == (A)) && (v[1] == (B)) && (v[2] == (C)))
-
-		// Check for non-zero elements
-		if (CMPINDICES(1,4,6) || CMPINDICES(1,5,7) || CMPINDICES(2,5,6)
-		 || CMPINDICES(3,4,4) || CMPINDICES(3,5,5))
-			return _ex1_2;
-		else if (CMPINDICES(2,4,7) || CMPINDICES(3,6,6) || CMPINDICES(3,7,7))
-			return _ex_1_2;
-		else if (CMPINDICES(1,1,8) || CMPINDICES(2,2,8) || CMPINDICES(3,3,8))
-			return sqrt(_ex3)*_ex1_3;
-		else if (CMPINDICES(8,8,8))
-			return sqrt(_ex3)*_ex_1_3;
-		else if (CMPINDICES(4,4,8) || CMPINDICES(5,5,8)
-		      || CMPINDICES(6,6,8) || CMPINDICES(7,7,8))
-			return sqrt(_ex3)/_ex_6;
-		else
+		// Look up the value
+		if (v[2] > 8)
 			return _ex0;
+		return su3d_table()[su3_table_index(v)];
 	}
 
 	// No further simplifications
@@ -282,18 +322,11 @@ ex su3f::eval_indexed(const basic & i) const
 		if (v[0] > v[2]) { std::swap(v[0], v[2]); sign = -sign; }
 		if (v[1] > v[2]) { std::swap(v[1], v[2]); sign = -sign; }
 
-		// Check for non-zero elements
-		if (CMPINDICES(1,2,3))
-			return sign;
-		else if (CMPINDICES(1,4,7) || CMPINDICES(2,4,6)
-		      || CMPINDICES(2,5,7) || CMPINDICES(3,4,5))
-			return _ex1_2 * sign;
-		else if (CMPINDICES(1,5,6) || CMPINDICES(3,6,7))
-			return _ex_1_2 * sign;
-		else if (CMPINDICES(4,5,8) || CMPINDICES(6,7,8))
-			return sqrt(_ex3)/2 * sign;
-		else
+		// Look up the value
+		if (v[2] > 8)
 			return _ex0;
+		const ex & value = su3f_table()[su3_table_index(v)];
+		return sign > 0 ? value : -value;
 	}
 
 	// No further simplifications
@@ -529,6 +562,76 @@ static unsigned char get_representation_label(const return_type_t& ti)
 	return (unsigned char)ti.rl;
 }
 
+/** Product of a string of generators (the unit for an empty string). */
+static ex generator_string(const exvector & v, unsigned char rl)
+{
+	if (v.empty())
+		return color_ONE(rl);
+	if (v.size() == 1)
+		return v[0];
+	return ncmul(v);
+}
+
+/** Trace of a string of generators with different placeholder indices. */
+struct trace_template {
+	exvector indices; /**< Placeholder indices */
+	exvector dummies; /**< Values of the summation indices in the trace */
+	ex value;         /**< The trace */
+};
+
+/** Return the trace of n generators with different indices. The traces are
+ *  computed only once, with placeholder indices, using the recursion
+ *  Tr T_a1 .. T_an =
+ *      1/6 delta_a(n-1)_an Tr T_a1 .. T_a(n-2)
+ *    + 1/2 h_a(n-1)_an_k Tr T_a1 .. T_a(n-2) T_k
+ *  on the cached shorter traces. */
+static const trace_template & generic_trace(size_t n)
+{
+	static std::vector<trace_template> cache;
+
+	while (cache.size() <= n) {
+		size_t len = cache.size();
+		trace_template t;
+		for (size_t i=0; i<len; i++)
+			t.indices.push_back(idx(dynallocate<symbol>(), 8));
+
+		if (len < 2) {
+			t.value = len == 0 ? _ex3 : _ex0;
+		} else if (len == 2) {
+			t.value = delta_tensor(t.indices[0], t.indices[1]) / 2;
+		} else if (len == 3) {
+			t.value = color_h(t.indices[0], t.indices[1], t.indices[2]) / 4;
+		} else {
+			const ex & last_index = t.indices[len - 1];
+			const ex & next_to_last_index = t.indices[len - 2];
+			ex k = dynallocate<symbol>();
+			ex summation_index = idx(k, 8);
+			t.dummies.push_back(k);
+
+			// Copy of a shorter trace with new indices and new summation
+			// indices
+			auto shorter = [&](const trace_template & s, const ex & extra_index) {
+				exmap m;
+				for (size_t i=0; i<len-2; i++)
+					m[s.indices[i]] = t.indices[i];
+				if (s.indices.size() > len - 2)
+					m[s.indices[len - 2]] = extra_index;
+				for (auto & d : s.dummies) {
+					ex new_d = dynallocate<symbol>();
+					m[d] = new_d;
+					t.dummies.push_back(new_d);
+				}
+				return s.value.subs(m, subs_options::no_pattern);
+			};
+
+			t.value = delta_tensor(next_to_last_index, last_index) * shorter(cache[len - 2], summation_index) / 6
+			        + color_h(next_to_last_index, last_index, summation_index) * shorter(cache[len - 1], summation_index) / 2;
+		}
+		cache.push_back(std::move(t));
+	}
+	return cache[n];
+}
+
 ex color_trace(const ex & e, const std::set<unsigned char> & rls)
 {
 	if (is_a<color>(e)) {
@@ -585,24 +688,37 @@ ex color_trace(const ex & e, const std::set<unsigned char> & rls)
 
 		} else {
 
-			// Traces of 4 or more generators are computed recursively:
-			// Tr T_a1 .. T_an =
-			//     1/6 delta_a(n-1)_an Tr T_a1 .. T_a(n-2)
-			//   + 1/2 h_a(n-1)_an_k Tr T_a1 .. T_a(n-2) T_k
-			const ex &last_index = e.op(num - 1).op(1);
-			const ex &next_to_last_index = e.op(num - 2).op(1);
-			idx summation_index(dynallocate<symbol>(), 8);
-
-			exvector v1;
-			v1.reserve(num - 2);
-			for (size_t i=0; i<num-2; i++)
-				v1.push_back(e.op(i));
-
-			exvector v2 = v1;
-			v2.push_back(color_T(summation_index, rl));
+			// Two generators with the same index are removed with the
+			// Fierz identity:
+			// Tr A T_a B T_a C = 1/2 Tr B Tr A C - 1/6 Tr A B C
+			for (size_t i=0; i<num; i++) {
+				for (size_t j=i+1; j<num; j++) {
+					if (!is_dummy_pair(e.op(i).op(1), e.op(j).op(1)))
+						continue;
+					exvector b, ac;
+					for (size_t k=0; k<num; k++) {
+						if (k > i && k < j)
+							b.push_back(e.op(k));
+						else if (k != i && k != j)
+							ac.push_back(e.op(k));
+					}
+					exvector abc(ac.begin(), ac.begin() + i);
+					abc.insert(abc.end(), b.begin(), b.end());
+					abc.insert(abc.end(), ac.begin() + i, ac.end());
+					return color_trace(generator_string(b, rl), rl) * color_trace(generator_string(ac, rl), rl) / 2
+					       - color_trace(generator_string(abc, rl), rl) / 6;
+				}
+			}
 
-			return delta_tensor(next_to_last_index, last_index) * color_trace(ncmul(v1), rl) / 6
-			       + color_h(next_to_last_index, last_index, summation_index) * color_trace(ncmul(v2), rl) / 2;
+			// Traces of 4 or more different generators are taken from the
+			// cache
+			const trace_template & t = generic_trace(num);
+			exmap m;
+			for (size_t i=0; i<num; i++)
+				m[t.indices[i]] = e.op(i).op(1);
+			for (auto & d : t.dummies)
+				m[d] = dynallocate<symbol>();
+			return t.value.subs(m, subs_options::no_pattern);
 		}
 
 	} else if (e.nops() > 0) {
@@ -64,6 +64,7 @@
 #include "mul.h"
 #include "normal.h"
 #include "add.h"
+#include "polynomial/half_gcd.h"
 
 #include <type_traits>
 #include <algorithm>
@@ -577,6 +578,10 @@ static void remdiv(const umodpoly& a, const umodpoly& b, umodpoly& r, umodpoly&
 static void gcd(const umodpoly& a, const umodpoly& b, umodpoly& c)
 {
 	if ( degree(a) < degree(b) ) return gcd(b, a, c);
+	if ( degree(b) >= int(half_gcd_threshold) ) {
+		half_gcd(c, a, b);
+		return;
+	}
 
 	c = a;
 	normalize_in_field(c);
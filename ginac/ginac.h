@@ -67,6 +67,8 @@
 #include "clifford.h"
 
 #include "factor.h"
+#include "ratfunc.h"
+#include "gradient.h"
 
 #include "integration_kernel.h"
 
@@ -0,0 +1,871 @@
+/** @file gradient.cpp
+ *
+ *  Gradients, Jacobians and Hessians by reverse-mode differentiation
+ *  (implementation).
+ *
+ *  The expression is first flattened into a graph whose nodes are the
+ *  distinct subexpressions depending on at least one of the symbols, in
+ *  post-order, so that every node comes after its operands.  A reverse sweep
+ *  then walks this list backwards, starting with adjoint 1 at the root, and
+ *  hands adjoint*(local partial derivative) on to the operands.  Since
+ *  every node is processed after all its parents, its adjoint is complete
+ *  when it is visited and is summed only once.  The adjoints arriving at
+ *  the symbols form the gradient.
+ *
+ *  Sums, products, powers and functions are taken apart; the local partial
+ *  derivatives of a function are obtained from its registered derivative
+ *  by differentiating with respect to a temporary symbol.  All other
+ *  objects are treated as leaves and differentiated with diff().
+ *
+ *  Higher derivatives in one symbol are computed for all orders at once and
+ *  memoized per subexpression: sums add the derivatives of their terms,
+ *  products use the Leibniz rule, and powers and functions with a single
+ *  argument depending on the symbol use the formula of Faa di Bruno with
+ *  partial Bell polynomials.  This avoids differentiating the ever growing
+ *  previous result again for every order. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "gradient.h"
+#include "ex.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "function.h"
+#include "inifcns.h"
+#include "symbol.h"
+#include "lst.h"
+#include "matrix.h"
+#include "numeric.h"
+#include "relational.h"
+#include "operators.h"
+#include "hash_map.h"
+#include "utils.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace GiNaC {
+
+namespace {
+
+/** Returns true if e is a function whose derivatives follow from the chain
+ *  rule.  Functions with an explicit derivative, like abs() or conjugate(),
+ *  are not holomorphic and must be differentiated as a whole. */
+bool obeys_chain_rule(const ex & e)
+{
+	return is_a<function>(e) && !ex_to<function>(e).has_expl_derivative();
+}
+
+/** One distinct subexpression of the differentiated expression. */
+struct ad_node {
+	ex e;
+	int var = -1;              ///< index of the symbol if e is one of the variables
+	bool opaque = false;       ///< e is not taken apart but differentiated with diff()
+	bool have_partials = false;
+	std::vector<size_t> args;  ///< nodes of the operands depending on the variables
+	std::vector<size_t> pos;   ///< operand positions of these nodes
+	exvector partials;         ///< de/dop(pos[k]), or de/dvars[k] if opaque
+};
+
+class reverse_sweep {
+public:
+	explicit reverse_sweep(const exvector & v) : vars(v) {}
+
+	/** Enters e into the graph and returns its node, or npos if e does not
+	 *  depend on the variables. */
+	size_t add_root(const ex & e) { return visit(e); }
+
+	/** Returns the derivatives of the root with respect to all variables. */
+	exvector sweep(size_t root);
+
+	static const size_t npos = size_t(-1);
+
+private:
+	size_t visit(const ex & e);
+	void compute_partials(ad_node & n);
+
+	exvector vars;
+	std::vector<ad_node> nodes;
+	exhashmap<size_t> index;
+};
+
+const size_t reverse_sweep::npos;
+
+size_t reverse_sweep::visit(const ex & e)
+{
+	auto found = index.find(e);
+	if (found != index.end())
+		return found->second;
+
+	ad_node n;
+	n.e = e;
+	if (is_a<symbol>(e)) {
+		for (size_t k = 0; k < vars.size(); ++k) {
+			if (e.is_equal(vars[k])) {
+				n.var = k;
+				break;
+			}
+		}
+		if (n.var < 0)
+			return index[e] = npos;
+	} else if (is_exactly_a<add>(e) || is_exactly_a<mul>(e) ||
+	           is_exactly_a<power>(e) || obeys_chain_rule(e)) {
+		for (size_t i = 0; i < e.nops(); ++i) {
+			size_t a = visit(e.op(i));
+			if (a != npos) {
+				n.args.push_back(a);
+				n.pos.push_back(i);
+			}
+		}
+		if (n.args.empty())
+			return index[e] = npos;
+	} else {
+		bool depends = false;
+		for (auto & v : vars) {
+			if (e.has(v)) {
+				depends = true;
+				break;
+			}
+		}
+		if (!depends)
+			return index[e] = npos;
+		n.opaque = true;
+	}
+
+	nodes.push_back(std::move(n));
+	return index[e] = nodes.size() - 1;
+}
+
+void reverse_sweep::compute_partials(ad_node & n)
+{
+	const ex & e = n.e;
+	if (n.opaque) {
+		for (auto & v : vars)
+			n.partials.push_back(e.diff(ex_to<symbol>(v)));
+	} else if (is_exactly_a<add>(e)) {
+		n.partials.assign(n.args.size(), _ex1);
+	} else if (is_exactly_a<mul>(e)) {
+		for (size_t k = 0; k < n.pos.size(); ++k) {
+			exvector others;
+			others.reserve(e.nops() - 1);
+			for (size_t i = 0; i < e.nops(); ++i) {
+				if (i != n.pos[k])
+					others.push_back(e.op(i));
+			}
+			n.partials.push_back(dynallocate<mul>(others));
+		}
+	} else if (is_exactly_a<power>(e)) {
+		const ex & b = e.op(0);
+		const ex & x = e.op(1);
+		for (size_t k = 0; k < n.pos.size(); ++k) {
+			if (n.pos[k] == 0)
+				n.partials.push_back(x * pow(b, x - _ex1));
+			else
+				n.partials.push_back(e * log(b));
+		}
+	} else {
+		// function: differentiate with respect to a temporary symbol put in
+		// place of the argument and substitute the argument back
+		for (size_t k = 0; k < n.pos.size(); ++k) {
+			const ex & arg = e.op(n.pos[k]);
+			symbol t;
+			ex f = e;
+			f.let_op(n.pos[k]) = t;
+			ex d = f.eval().diff(t);
+			n.partials.push_back(d.subs(t == arg, subs_options::no_pattern));
+		}
+	}
+	n.have_partials = true;
+}
+
+exvector reverse_sweep::sweep(size_t root)
+{
+	std::vector<exvector> gterms(vars.size());
+	if (root != npos) {
+		std::vector<exvector> terms(root + 1);
+		terms[root].push_back(_ex1);
+		for (size_t i = root + 1; i-- > 0; ) {
+			if (terms[i].empty())
+				continue;
+			ex adj = terms[i].size() == 1 ? terms[i][0] : dynallocate<add>(terms[i]);
+			exvector().swap(terms[i]);
+			if (adj.is_zero())
+				continue;
+
+			ad_node & n = nodes[i];
+			if (n.var >= 0) {
+				gterms[n.var].push_back(adj);
+				continue;
+			}
+			if (!n.have_partials)
+				compute_partials(n);
+			if (n.opaque) {
+				for (size_t k = 0; k < vars.size(); ++k) {
+					if (!n.partials[k].is_zero())
+						gterms[k].push_back(adj * n.partials[k]);
+				}
+				continue;
+			}
+			for (size_t k = 0; k < n.args.size(); ++k) {
+				const ex & p = n.partials[k];
+				if (p.is_zero())
+					continue;
+				terms[n.args[k]].push_back(p.is_equal(_ex1) ? adj : adj * p);
+			}
+		}
+	}
+
+	exvector grad;
+	grad.reserve(vars.size());
+	for (auto & g : gterms) {
+		if (g.empty())
+			grad.push_back(_ex0);
+		else if (g.size() == 1)
+			grad.push_back(g[0]);
+		else
+			grad.push_back(dynallocate<add>(g));
+	}
+	return grad;
+}
+
+/** Derivatives of orders 0..n of the subexpressions of an expression with
+ *  respect to one symbol. */
+class taylor_diff {
+public:
+	taylor_diff(const symbol & s_, unsigned n_) : s(s_), n(n_) {}
+
+	/** Returns the derivatives of e of orders 0..n. */
+	const exvector & derivs(const ex & e);
+
+private:
+	exvector iterated(const ex & e) const;
+	exvector leibniz(const ex & e);
+	exvector faa_di_bruno(const ex & e, size_t p, const exvector & ud) const;
+
+	symbol s;
+	unsigned n;
+	exhashmap<exvector> memo;
+};
+
+/** Returns true if all derivatives of positive order vanish. */
+bool is_constant(const exvector & d)
+{
+	for (size_t k = 1; k < d.size(); ++k)
+		if (!d[k].is_zero())
+			return false;
+	return true;
+}
+
+ex sum_of(exvector & terms)
+{
+	if (terms.empty())
+		return _ex0;
+	if (terms.size() == 1)
+		return terms[0];
+	return dynallocate<add>(terms);
+}
+
+const exvector & taylor_diff::derivs(const ex & e)
+{
+	auto found = memo.find(e);
+	if (found != memo.end())
+		return found->second;
+
+	exvector d(n + 1, _ex0);
+	d[0] = e;
+	if (is_a<symbol>(e)) {
+		if (e.is_equal(s) && n > 0)
+			d[1] = _ex1;
+	} else if (is_exactly_a<add>(e)) {
+		std::vector<exvector> terms(n + 1);
+		for (size_t i = 0; i < e.nops(); ++i) {
+			const exvector & od = derivs(e.op(i));
+			for (size_t k = 1; k <= n; ++k)
+				if (!od[k].is_zero())
+					terms[k].push_back(od[k]);
+		}
+		for (size_t k = 1; k <= n; ++k)
+			d[k] = sum_of(terms[k]);
+	} else if (is_exactly_a<mul>(e)) {
+		d = leibniz(e);
+	} else if (is_exactly_a<power>(e) || obeys_chain_rule(e)) {
+		// find the operands depending on s
+		size_t p = e.nops();
+		unsigned dependent = 0;
+		for (size_t i = 0; i < e.nops(); ++i) {
+			if (!is_constant(derivs(e.op(i)))) {
+				p = i;
+				++dependent;
+			}
+		}
+		if (dependent == 1 && !is_a<lst>(e.op(p)) && !is_a<exprseq>(e.op(p))) {
+			exvector ud = derivs(e.op(p));
+			d = faa_di_bruno(e, p, ud);
+		} else if (dependent > 0)
+			d = iterated(e);
+	} else if (e.has(s))
+		d = iterated(e);
+
+	return memo[e] = std::move(d);
+}
+
+/** Fallback: differentiate the previous order again. */
+exvector taylor_diff::iterated(const ex & e) const
+{
+	exvector d(n + 1, _ex0);
+	d[0] = e;
+	for (size_t k = 1; k <= n; ++k) {
+		d[k] = d[k-1].diff(s);
+		if (d[k].is_zero())
+			break;
+	}
+	return d;
+}
+
+/** Leibniz rule, applied factor by factor.  Factors not depending on s are
+ *  collected into one constant coefficient. */
+exvector taylor_diff::leibniz(const ex & e)
+{
+	exvector c;
+	exvector acc;
+	for (size_t i = 0; i < e.nops(); ++i) {
+		const ex & f = e.op(i);
+		const exvector & fd = derivs(f);
+		if (is_constant(fd)) {
+			c.push_back(f);
+			continue;
+		}
+		if (acc.empty()) {
+			acc = fd;
+			continue;
+		}
+		exvector next(n + 1, _ex0);
+		for (size_t k = 0; k <= n; ++k) {
+			exvector terms;
+			for (size_t j = 0; j <= k; ++j) {
+				if (acc[j].is_zero() || fd[k-j].is_zero())
+					continue;
+				ex t = acc[j] * fd[k-j];
+				if (j != 0 && j != k)
+					t = t * binomial(numeric(k), numeric(j));
+				terms.push_back(t);
+			}
+			next[k] = sum_of(terms);
+		}
+		acc.swap(next);
+	}
+
+	exvector d(n + 1, _ex0);
+	d[0] = e;
+	if (acc.empty())
+		return d;
+	ex coeff = c.empty() ? _ex1 : dynallocate<mul>(c);
+	for (size_t k = 1; k <= n; ++k)
+		if (!acc[k].is_zero())
+			d[k] = coeff * acc[k];
+	return d;
+}
+
+/** Formula of Faa di Bruno for e = g(u) where u = e.op(p) is the only
+ *  operand depending on s, with derivatives ud. */
+exvector taylor_diff::faa_di_bruno(const ex & e, size_t p, const exvector & ud) const
+{
+	const ex & u = e.op(p);
+	symbol t;
+	ex g = e;
+	g.let_op(p) = t;
+	g = g.eval();
+
+	// outer derivatives g^(m)(u)
+	exvector gd(n + 1, _ex0);
+	ex gm = g;
+	for (size_t m = 1; m <= n; ++m) {
+		gm = gm.diff(t);
+		if (gm.is_zero())
+			break;
+		gd[m] = gm.subs(t == u, subs_options::no_pattern);
+	}
+
+	// partial Bell polynomials B[k][m] in ud[1], ud[2], ...
+	std::vector<exvector> B(n + 1, exvector(n + 1, _ex0));
+	B[0][0] = _ex1;
+	for (size_t k = 1; k <= n; ++k) {
+		for (size_t m = 1; m <= k; ++m) {
+			exvector terms;
+			for (size_t i = 1; i <= k - m + 1; ++i) {
+				if (ud[i].is_zero() || B[k-i][m-1].is_zero())
+					continue;
+				ex t = ud[i] * B[k-i][m-1];
+				if (i != 1 && i != k)
+					t = t * binomial(numeric(k - 1), numeric(i - 1));
+				terms.push_back(t);
+			}
+			B[k][m] = sum_of(terms);
+		}
+	}
+
+	exvector d(n + 1, _ex0);
+	d[0] = e;
+	for (size_t k = 1; k <= n; ++k) {
+		exvector terms;
+		for (size_t m = 1; m <= k; ++m)
+			if (!gd[m].is_zero() && !B[k][m].is_zero())
+				terms.push_back(gd[m] * B[k][m]);
+		d[k] = sum_of(terms);
+	}
+	return d;
+}
+
+/** Truncated Taylor series with numeric coefficients c[k] = f^(k)(a)/k!. */
+typedef std::vector<numeric> tseries;
+
+/** Numeric Taylor coefficients up to order n of the subexpressions of an
+ *  expression at the point s==a, propagated without building symbolic
+ *  derivatives. */
+class taylor_eval {
+public:
+	taylor_eval(const symbol & s_, const numeric & a_, unsigned n_) : s(s_), a(a_), n(n_) {}
+
+	/** Returns the Taylor coefficients of e at s==a. */
+	const tseries & coeffs(const ex & e);
+
+private:
+	tseries constant(const numeric & c) const;
+	numeric to_numeric(const ex & v) const;
+	tseries product(const tseries & u, const tseries & v) const;
+	tseries power(const tseries & u, const numeric & r) const;
+	tseries exp_series(const tseries & u) const;
+	tseries log_series(const tseries & u) const;
+	void sincos_series(const tseries & u, tseries & sn, tseries & cs, bool hyperbolic) const;
+	tseries tan_series(const tseries & u, bool hyperbolic) const;
+	tseries integral_series(const numeric & w0, const tseries & u, const tseries & q) const;
+	tseries function_series(const ex & e, size_t p, const tseries & u) const;
+	tseries compose(const ex & e, size_t p, const tseries & u) const;
+	tseries symbolic(const ex & e) const;
+
+	symbol s;
+	numeric a;
+	unsigned n;
+	exhashmap<tseries> memo;
+};
+
+bool is_constant(const tseries & u)
+{
+	for (size_t k = 1; k < u.size(); ++k)
+		if (!u[k].is_zero())
+			return false;
+	return true;
+}
+
+tseries taylor_eval::constant(const numeric & c) const
+{
+	tseries u(n + 1, *_num0_p);
+	u[0] = c;
+	return u;
+}
+
+numeric taylor_eval::to_numeric(const ex & v) const
+{
+	ex f = v.evalf();
+	if (!is_exactly_a<numeric>(f)) {
+		std::ostringstream os;
+		os << "numeric_derivatives(): " << v << " could not be evaluated numerically";
+		throw (std::invalid_argument(os.str()));
+	}
+	return ex_to<numeric>(f);
+}
+
+tseries taylor_eval::product(const tseries & u, const tseries & v) const
+{
+	tseries w(n + 1, *_num0_p);
+	for (size_t i = 0; i <= n; ++i) {
+		if (u[i].is_zero())
+			continue;
+		for (size_t j = 0; i + j <= n; ++j)
+			w[i+j] += u[i] * v[j];
+	}
+	return w;
+}
+
+tseries taylor_eval::power(const tseries & u, const numeric & r) const
+{
+	if (u[0].is_zero()) {
+		// not analytic unless the exponent is a nonnegative integer
+		if (!r.is_nonneg_integer())
+			throw (std::invalid_argument("numeric_derivatives(): power is not analytic at the point"));
+		tseries w = constant(*_num1_p);
+		tseries b = u;
+		for (long e = r.to_long(); e > 0; e >>= 1) {
+			if (e & 1)
+				w = product(w, b);
+			if (e > 1)
+				b = product(b, b);
+		}
+		return w;
+	}
+	tseries w(n + 1, *_num0_p);
+	w[0] = u[0].power(r);
+	for (size_t k = 1; k <= n; ++k) {
+		numeric sum;
+		for (size_t j = 1; j <= k; ++j)
+			sum += ((r + 1) * j - k) * u[j] * w[k-j];
+		w[k] = sum / (k * u[0]);
+	}
+	return w;
+}
+
+tseries taylor_eval::exp_series(const tseries & u) const
+{
+	tseries w(n + 1, *_num0_p);
+	w[0] = exp(u[0]);
+	for (size_t k = 1; k <= n; ++k) {
+		numeric sum;
+		for (size_t j = 1; j <= k; ++j)
+			sum += j * u[j] * w[k-j];
+		w[k] = sum / k;
+	}
+	return w;
+}
+
+tseries taylor_eval::log_series(const tseries & u) const
+{
+	if (u[0].is_zero())
+		throw (std::invalid_argument("numeric_derivatives(): logarithm is not analytic at the point"));
+	tseries w(n + 1, *_num0_p);
+	w[0] = log(u[0]);
+	for (size_t k = 1; k <= n; ++k) {
+		numeric sum;
+		for (size_t j = 1; j < k; ++j)
+			sum += j * w[j] * u[k-j];
+		w[k] = (u[k] - sum / k) / u[0];
+	}
+	return w;
+}
+
+void taylor_eval::sincos_series(const tseries & u, tseries & sn, tseries & cs, bool hyperbolic) const
+{
+	sn.assign(n + 1, *_num0_p);
+	cs.assign(n + 1, *_num0_p);
+	sn[0] = hyperbolic ? sinh(u[0]) : sin(u[0]);
+	cs[0] = hyperbolic ? cosh(u[0]) : cos(u[0]);
+	for (size_t k = 1; k <= n; ++k) {
+		numeric ss, cc;
+		for (size_t j = 1; j <= k; ++j) {
+			ss += j * u[j] * cs[k-j];
+			cc += j * u[j] * sn[k-j];
+		}
+		sn[k] = ss / k;
+		cs[k] = hyperbolic ? cc / k : -cc / k;
+	}
+}
+
+/** tan(u) from w' = (1 + w^2) u', tanh(u) from w' = (1 - w^2) u'. */
+tseries taylor_eval::tan_series(const tseries & u, bool hyperbolic) const
+{
+	tseries w(n + 1, *_num0_p);
+	tseries v(n + 1, *_num0_p);
+	w[0] = hyperbolic ? tanh(u[0]) : tan(u[0]);
+	for (size_t k = 1; k <= n; ++k) {
+		numeric sq;
+		for (size_t i = 0; i < k; ++i)
+			sq += w[i] * w[k-1-i];
+		v[k-1] = hyperbolic ? -sq : sq;
+		if (k == 1)
+			v[0] += 1;
+		numeric sum;
+		for (size_t j = 1; j <= k; ++j)
+			sum += j * u[j] * v[k-j];
+		w[k] = sum / k;
+	}
+	return w;
+}
+
+/** Solves w' = q u' for w with w(a) = w0. */
+tseries taylor_eval::integral_series(const numeric & w0, const tseries & u, const tseries & q) const
+{
+	tseries w(n + 1, *_num0_p);
+	w[0] = w0;
+	for (size_t k = 1; k <= n; ++k) {
+		numeric sum;
+		for (size_t j = 1; j <= k; ++j)
+			sum += j * u[j] * q[k-j];
+		w[k] = sum / k;
+	}
+	return w;
+}
+
+/** Series of a function whose only argument depending on s is u = op(p). */
+tseries taylor_eval::function_series(const ex & e, size_t p, const tseries & u) const
+{
+	static const numeric half = numeric(1, 2);
+	if (e.nops() == 1) {
+		tseries sn, cs;
+		if (is_ex_the_function(e, exp))
+			return exp_series(u);
+		if (is_ex_the_function(e, log))
+			return log_series(u);
+		if (is_ex_the_function(e, sin) || is_ex_the_function(e, cos)) {
+			sincos_series(u, sn, cs, false);
+			return is_ex_the_function(e, sin) ? sn : cs;
+		}
+		if (is_ex_the_function(e, sinh) || is_ex_the_function(e, cosh)) {
+			sincos_series(u, sn, cs, true);
+			return is_ex_the_function(e, sinh) ? sn : cs;
+		}
+		if (is_ex_the_function(e, tan))
+			return tan_series(u, false);
+		if (is_ex_the_function(e, tanh))
+			return tan_series(u, true);
+
+		// inverse functions: w' = q(u) u' with algebraic q
+		tseries u2 = product(u, u);
+		tseries one = constant(*_num1_p);
+		tseries onepu2(n + 1), onemu2(n + 1);
+		for (size_t k = 0; k <= n; ++k) {
+			onepu2[k] = one[k] + u2[k];
+			onemu2[k] = one[k] - u2[k];
+		}
+		if (is_ex_the_function(e, atan))
+			return integral_series(atan(u[0]), u, power(onepu2, -1));
+		if (is_ex_the_function(e, atanh))
+			return integral_series(atanh(u[0]), u, power(onemu2, -1));
+		if (is_ex_the_function(e, asinh))
+			return integral_series(asinh(u[0]), u, power(onepu2, -half));
+		if (is_ex_the_function(e, asin) || is_ex_the_function(e, acos)) {
+			tseries q = power(onemu2, -half);
+			if (is_ex_the_function(e, asin))
+				return integral_series(asin(u[0]), u, q);
+			for (auto & c : q)
+				c = -c;
+			return integral_series(acos(u[0]), u, q);
+		}
+		if (is_ex_the_function(e, acosh)) {
+			// 1/(sqrt(u-1)*sqrt(u+1)) has the right branch for complex u
+			tseries um1 = u, up1 = u;
+			um1[0] -= 1;
+			up1[0] += 1;
+			return integral_series(acosh(u[0]), u, product(power(um1, -half), power(up1, -half)));
+		}
+	}
+	return compose(e, p, u);
+}
+
+/** Composes the numeric derivatives of the outer function, taken with
+ *  respect to a temporary symbol in place of u = op(p), with the series of
+ *  u.  Only the outer function is differentiated symbolically, which is
+ *  cheap for the built-in functions like tgamma, lgamma, psi or zeta. */
+tseries taylor_eval::compose(const ex & e, size_t p, const tseries & u) const
+{
+	symbol t;
+	ex g = e;
+	g.let_op(p) = t;
+	g = g.eval();
+
+	tseries d = u;
+	d[0] = 0;
+	tseries w(n + 1, *_num0_p);
+	tseries dm = constant(*_num1_p);
+	numeric mfac = 1;
+	for (size_t m = 0; m <= n; ++m) {
+		if (m > 0) {
+			g = g.diff(t);
+			mfac *= m;
+			dm = product(dm, d);
+		}
+		if (g.is_zero())
+			break;
+		numeric gm = to_numeric(g.subs(t == u[0], subs_options::no_pattern)) / mfac;
+		for (size_t k = m; k <= n; ++k)
+			w[k] += gm * dm[k];
+	}
+	return w;
+}
+
+/** Fallback: symbolic derivatives, evaluated at the point. */
+tseries taylor_eval::symbolic(const ex & e) const
+{
+	ex d = derivatives(e, s, n);
+	tseries w(n + 1, *_num0_p);
+	numeric kfac = 1;
+	for (size_t k = 0; k <= n; ++k) {
+		if (k > 0)
+			kfac *= k;
+		w[k] = to_numeric(d.op(k).subs(s == a, subs_options::no_pattern)) / kfac;
+	}
+	return w;
+}
+
+const tseries & taylor_eval::coeffs(const ex & e)
+{
+	auto found = memo.find(e);
+	if (found != memo.end())
+		return found->second;
+
+	tseries w;
+	if (is_exactly_a<numeric>(e)) {
+		w = constant(ex_to<numeric>(e));
+	} else if (is_a<symbol>(e) && e.is_equal(s)) {
+		w = constant(a);
+		if (n > 0)
+			w[1] = 1;
+	} else if (is_exactly_a<add>(e)) {
+		w = constant(*_num0_p);
+		for (size_t i = 0; i < e.nops(); ++i) {
+			const tseries & u = coeffs(e.op(i));
+			for (size_t k = 0; k <= n; ++k)
+				w[k] += u[k];
+		}
+	} else if (is_exactly_a<mul>(e)) {
+		w = constant(*_num1_p);
+		for (size_t i = 0; i < e.nops(); ++i)
+			w = product(w, coeffs(e.op(i)));
+	} else if (is_exactly_a<GiNaC::power>(e)) {
+		const tseries & u = coeffs(e.op(0));
+		const tseries & x = coeffs(e.op(1));
+		if (is_constant(x))
+			w = power(u, x[0]);
+		else
+			w = exp_series(product(x, log_series(u)));
+	} else if (is_a<function>(e)) {
+		size_t p = e.nops();
+		unsigned dependent = 0;
+		for (size_t i = 0; i < e.nops(); ++i) {
+			if (is_a<lst>(e.op(i)) || is_a<exprseq>(e.op(i))) {
+				if (e.op(i).has(s))
+					dependent = 2;
+				continue;
+			}
+			if (!is_constant(coeffs(e.op(i)))) {
+				p = i;
+				++dependent;
+			}
+		}
+		if (dependent == 0)
+			w = constant(to_numeric(e));
+		else if (dependent == 1 && obeys_chain_rule(e))
+			w = function_series(e, p, coeffs(e.op(p)));
+		else
+			w = symbolic(e);
+	} else if (e.has(s)) {
+		w = symbolic(e);
+	} else {
+		w = constant(to_numeric(e));
+	}
+
+	return memo[e] = std::move(w);
+}
+
+/** Checks that vars is a list of symbols and returns its elements. */
+exvector symbol_list(const ex & vars, const char * caller)
+{
+	if (!is_a<lst>(vars))
+		throw (std::invalid_argument(std::string(caller) + "(): 2nd argument must be a list of symbols"));
+	exvector v(vars.begin(), vars.end());
+	for (auto & s : v) {
+		if (!is_a<symbol>(s))
+			throw (std::invalid_argument(std::string(caller) + "(): 2nd argument must be a list of symbols"));
+	}
+	return v;
+}
+
+} // anonymous namespace
+
+ex gradient(const ex & e, const ex & vars)
+{
+	reverse_sweep rs(symbol_list(vars, "gradient"));
+	exvector grad = rs.sweep(rs.add_root(e));
+	return lst(grad.begin(), grad.end());
+}
+
+ex jacobian(const ex & fs, const ex & vars)
+{
+	if (!is_a<lst>(fs))
+		throw (std::invalid_argument("jacobian(): 1st argument must be a list"));
+	reverse_sweep rs(symbol_list(vars, "jacobian"));
+
+	// enter all rows first so that the sweeps share one graph
+	std::vector<size_t> roots;
+	for (const auto & f : fs)
+		roots.push_back(rs.add_root(f));
+
+	matrix J(fs.nops(), vars.nops());
+	for (size_t r = 0; r < roots.size(); ++r) {
+		exvector row = rs.sweep(roots[r]);
+		for (size_t c = 0; c < row.size(); ++c)
+			J(r, c) = row[c];
+	}
+	return J;
+}
+
+ex hessian(const ex & e, const ex & vars)
+{
+	matrix H = ex_to<matrix>(jacobian(gradient(e, vars), vars));
+	// make the result symmetric in form, not only in value
+	for (unsigned r = 1; r < H.rows(); ++r)
+		for (unsigned c = 0; c < r; ++c)
+			H(r, c) = H(c, r);
+	return H;
+}
+
+ex derivatives(const ex & e, const symbol & s, unsigned nth)
+{
+	taylor_diff td(s, nth);
+	const exvector & d = td.derivs(e);
+	return lst(d.begin(), d.end());
+}
+
+ex mixed_diff(const ex & e, const ex & orders)
+{
+	if (!is_a<lst>(orders))
+		throw (std::invalid_argument("mixed_diff(): 2nd argument must be a list"));
+	ex r = e;
+	for (const auto & o : orders) {
+		if (is_a<symbol>(o)) {
+			r = r.diff(ex_to<symbol>(o));
+		} else if (is_a<relational>(o) && is_a<symbol>(o.lhs()) &&
+		           o.rhs().info(info_flags::nonnegint)) {
+			r = r.diff(ex_to<symbol>(o.lhs()), ex_to<numeric>(o.rhs()).to_int());
+		} else
+			throw (std::invalid_argument("mixed_diff(): list elements must be symbols or relations symbol==order"));
+		if (r.is_zero())
+			break;
+	}
+	return r;
+}
+
+ex numeric_derivatives(const ex & e, const symbol & s, const ex & point, unsigned nth)
+{
+	ex a = point.evalf();
+	if (!is_exactly_a<numeric>(a))
+		throw (std::invalid_argument("numeric_derivatives(): point must be numeric"));
+	taylor_eval te(s, ex_to<numeric>(a), nth);
+	tseries c = te.coeffs(e);
+	lst result;
+	numeric kfac = 1;
+	for (size_t k = 0; k <= nth; ++k) {
+		if (k > 0)
+			kfac *= k;
+		result.append(c[k] * kfac);
+	}
+	return result;
+}
+
+} // namespace GiNaC
@@ -0,0 +1,100 @@
+/** @file gradient.h
+ *
+ *  Gradients, Jacobians, Hessians and higher-order derivatives, symbolic
+ *  and numeric. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_GRADIENT_H
+#define GINAC_GRADIENT_H
+
+namespace GiNaC {
+
+class ex;
+class symbol;
+
+/** Computes all first partial derivatives of an expression at once.
+ *
+ *  The expression is visited once, every distinct subexpression is entered
+ *  only once, and the adjoints (derivatives of e with respect to the
+ *  subexpressions) are propagated from the root towards the symbols.  This
+ *  is much cheaper than calling diff() for every symbol separately when e
+ *  is large and shares subexpressions.
+ *
+ *  @param[in] e     expression to differentiate
+ *  @param[in] vars  list of symbols
+ *  @return          list of the partial derivatives, in the order of vars */
+extern ex gradient(const ex & e, const ex & vars);
+
+/** Computes the Jacobian matrix of a list of expressions.  The reverse
+ *  sweeps for the individual rows share the expression graph and the local
+ *  partial derivatives of all common subexpressions.
+ *
+ *  @param[in] fs    list of expressions (one row each)
+ *  @param[in] vars  list of symbols (one column each)
+ *  @return          matrix of the partial derivatives */
+extern ex jacobian(const ex & fs, const ex & vars);
+
+/** Computes the Hessian matrix of an expression as the Jacobian of its
+ *  gradient.
+ *
+ *  @param[in] e     expression to differentiate
+ *  @param[in] vars  list of symbols
+ *  @return          symmetric matrix of the second partial derivatives */
+extern ex hessian(const ex & e, const ex & vars);
+
+/** Computes the derivatives of orders 0 to nth of an expression with respect
+ *  to one symbol.  The derivatives of every subexpression are computed for
+ *  all orders at once and reused, using the Leibniz rule for products and
+ *  the formula of Faa di Bruno for powers and functions.  This is what
+ *  ex::diff() uses for higher orders, and it gives all Taylor coefficients
+ *  at the price of the highest one.
+ *
+ *  @param[in] e    expression to differentiate
+ *  @param[in] s    symbol
+ *  @param[in] nth  highest order
+ *  @return         list of the nth+1 derivatives, starting with e itself */
+extern ex derivatives(const ex & e, const symbol & s, unsigned nth);
+
+/** Computes a mixed partial derivative given by a multi-index.
+ *
+ *  @param[in] e       expression to differentiate
+ *  @param[in] orders  list whose elements are either symbols (first
+ *                     derivative) or relations symbol==n (nth derivative),
+ *                     e.g. {x==2, y}
+ *  @return            the mixed partial derivative */
+extern ex mixed_diff(const ex & e, const ex & orders);
+
+/** Computes numeric values of the derivatives of orders 0 to nth of an
+ *  expression at a point.  Truncated Taylor series with numeric coefficients
+ *  are propagated through sums, products, powers and the elementary
+ *  functions, so no symbolic derivatives are built.  Other functions are
+ *  composed from the numeric derivatives of the function itself.
+ *
+ *  @param[in] e      expression, numeric except for s
+ *  @param[in] s      symbol
+ *  @param[in] point  numeric value of s
+ *  @param[in] nth    highest order
+ *  @return           list of the nth+1 numeric derivatives at s==point
+ *  @exception invalid_argument (e is not numeric or not analytic at the point) */
+extern ex numeric_derivatives(const ex & e, const symbol & s, const ex & point, unsigned nth);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_GRADIENT_H
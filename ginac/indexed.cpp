@@ -36,9 +36,12 @@
 #include "integral.h"
 #include "matrix.h"
 #include "inifcns.h"
+#include "hash_map.h"
+#include "numeric.h"
 
 #include <iostream>
 #include <limits>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 
@@ -771,6 +774,386 @@ template<class T> ex idx_symmetrization(const ex& r,const exvector& local_dummy_
 	return q;
 }
 
+/** Maximum number of complete labelings examined by the canonical dummy
+ *  index labeling. If the search tree is larger (which only happens for
+ *  products with a huge number of automorphisms), the best labeling found so
+ *  far is used. This is still a valid renaming, it just may not be canonical. */
+static const size_t max_dummy_labelings = 1024;
+
+typedef std::vector<long> color_signature;
+
+/** Replace a vector of signatures by the ranks of the signatures in the
+ *  sorted set of distinct signatures.
+ *
+ *  @return number of distinct signatures */
+static size_t rank_signatures(const std::vector<color_signature> & sig, std::vector<long> & colors)
+{
+	std::map<color_signature, long> ranks;
+	for (auto & s : sig)
+		ranks.insert(std::make_pair(s, 0));
+	long r = 0;
+	for (auto & it : ranks)
+		it.second = r++;
+	colors.resize(sig.size());
+	for (size_t i=0; i<sig.size(); ++i)
+		colors[i] = ranks[sig[i]];
+	return ranks.size();
+}
+
+/** Label-independent properties of an indexed factor. */
+struct dummy_factor_key {
+	std::string class_name;
+	return_type_t rt;
+	ex base;
+	ex symtree;
+	size_t num_indices;
+
+	bool operator<(const dummy_factor_key & other) const
+	{
+		int cmpval = class_name.compare(other.class_name);
+		if (cmpval)
+			return cmpval < 0;
+		if (rt != other.rt)
+			return rt < other.rt;
+		if (num_indices != other.num_indices)
+			return num_indices < other.num_indices;
+		cmpval = base.compare(other.base);
+		if (cmpval)
+			return cmpval < 0;
+		return symtree.compare(other.symtree) < 0;
+	}
+};
+
+/** This class computes a canonical labeling of the dummy indices of a
+ *  product of indexed objects, i.e. a renaming of the dummy indices such that
+ *  two products that only differ by the names of their dummy indices, the
+ *  order of commutative factors and by permutations of indices allowed by
+ *  the symmetries of the factors are mapped to the same expression.
+ *
+ *  The product is viewed as a graph whose vertices are the indexed factors
+ *  and the dummy indices, the edges being the index slots (labelled by the
+ *  orbit of the slot under the symmetry of the factor). Vertices are colored
+ *  by iterated refinement; remaining ties are broken by individualizing each
+ *  candidate in turn, and the lexicographically smallest resulting "word" of
+ *  symmetry-canonicalized factors selects the labeling. This is the usual
+ *  individualization-refinement scheme of graph canonization, which for
+ *  tensor monomials amounts to the double coset canonicalization of
+ *  Butler-Portugal. */
+class dummy_labeler {
+public:
+	dummy_labeler(const ex & e);
+
+	/** Return the canonically relabeled product. */
+	ex relabel();
+
+private:
+	struct slot_info {
+		unsigned orbit;  /**< representative of slot orbit under factor symmetry */
+		long deco;       /**< rank of index decoration (class, dimension, variance) */
+		long dummy;      /**< number of dummy index, or -1 for free index */
+		long code;       /**< rank of free index (only if dummy < 0) */
+	};
+
+	void refine(std::vector<long> & dcol, std::vector<long> & fcol) const;
+	void search(std::vector<long> dcol, std::vector<long> fcol);
+	std::vector<color_signature> word(const std::vector<long> & label) const;
+
+	ex orig;
+	bool ok;                                  /**< false if the product can't be handled */
+	exvector factors;                         /**< indexed factors */
+	std::vector<long> factor_key;             /**< rank of factor key */
+	std::vector<long> factor_nc;              /**< position of noncommutative factor, or -1 */
+	std::vector<std::vector<slot_info>> slots;
+	exvector dummy_syms;                      /**< symbols of dummy indices */
+	std::vector<std::string> dummy_class;     /**< index class of dummy indices */
+	std::vector<std::vector<std::pair<size_t, size_t>>> occurrences; /**< (factor, slot) of dummy indices */
+	long num_deco;
+	size_t num_leaves;
+	std::vector<color_signature> best_word;
+	std::vector<long> best_label;
+};
+
+dummy_labeler::dummy_labeler(const ex & e) : orig(e), ok(false), num_deco(0), num_leaves(0)
+{
+	exvector v;
+	if (is_a<indexed>(e))
+		v.push_back(e);
+	else {
+		bool non_commutative;
+		product_to_exvector(e, v, non_commutative);
+	}
+
+	// Collect all index slots of indexed factors
+	exvector all_indices, others;
+	for (auto & f : v) {
+		if (is_a<indexed>(f)) {
+			factors.push_back(f);
+			for (size_t i=1; i<f.nops(); ++i)
+				all_indices.push_back(f.op(i));
+		} else
+			others.push_back(f);
+	}
+	if (factors.empty())
+		return;
+
+	exvector free, dummy;
+	find_free_and_dummy(all_indices, free, dummy);
+	if (dummy.size() < 2)
+		return;
+
+	std::map<ex, long, ex_is_less> dummy_num;
+	for (auto & d : dummy) {
+		if (!is_a<symbol>(d.op(0)))
+			return;
+		dummy_num[d.op(0)] = dummy_syms.size();
+		dummy_syms.push_back(d.op(0));
+		dummy_class.push_back(ex_to<basic>(d).class_name());
+	}
+	occurrences.resize(dummy_syms.size());
+
+	// Dummy indices must not appear anywhere else in the product
+	for (auto & s : dummy_syms) {
+		for (auto & f : others)
+			if (f.has(s))
+				return;
+		for (auto & f : factors)
+			if (f.op(0).has(s))
+				return;
+	}
+
+	// Rank index decorations and free indices
+	static const ex placeholder = dynallocate<symbol>();
+	std::map<ex, long, ex_is_less> decos, free_codes;
+	for (auto & i : all_indices) {
+		auto it = dummy_num.find(i.op(0));
+		if (it != dummy_num.end())
+			decos.insert(std::make_pair(i.subs(exmap{{i.op(0), placeholder}}, subs_options::no_pattern), 0));
+		else
+			free_codes.insert(std::make_pair(i, 0));
+	}
+	for (auto & it : decos)
+		it.second = num_deco++;
+	long num_free = 0;
+	for (auto & it : free_codes)
+		it.second = num_free++;
+
+	// Set up factors and slots
+	std::map<dummy_factor_key, long> keys;
+	std::vector<dummy_factor_key> factor_keys;
+	long nc_pos = 0;
+	slots.resize(factors.size());
+	for (size_t f=0; f<factors.size(); ++f) {
+		const indexed & x = ex_to<indexed>(factors[f]);
+		size_t n = x.nops() - 1;
+		dummy_factor_key k = {x.class_name(), factors[f].return_type_tinfo(), x.op(0), x.get_symmetry(), n};
+		keys.insert(std::make_pair(k, 0));
+		factor_keys.push_back(k);
+		factor_nc.push_back(factors[f].return_type() == return_types::commutative ? -1 : nc_pos++);
+
+		std::vector<unsigned> orbit(n);
+		for (unsigned i=0; i<n; ++i)
+			orbit[i] = i;
+		ex_to<symmetry>(x.get_symmetry()).get_index_orbits(orbit);
+
+		for (size_t i=0; i<n; ++i) {
+			const ex & index = x.op(i + 1);
+			slot_info si = {orbit[i], 0, -1, 0};
+			auto it = dummy_num.find(index.op(0));
+			if (it != dummy_num.end()) {
+				si.dummy = it->second;
+				si.deco = decos[index.subs(exmap{{index.op(0), placeholder}}, subs_options::no_pattern)];
+				occurrences[si.dummy].push_back(std::make_pair(f, i));
+			} else
+				si.code = free_codes[index];
+			slots[f].push_back(si);
+		}
+	}
+	long r = 0;
+	for (auto & it : keys)
+		it.second = r++;
+	for (auto & k : factor_keys)
+		factor_key.push_back(keys[k]);
+
+	// Every dummy index must appear exactly twice
+	for (auto & o : occurrences)
+		if (o.size() != 2)
+			return;
+
+	ok = true;
+}
+
+/** Refine the coloring of factors and dummy indices until it is stable. */
+void dummy_labeler::refine(std::vector<long> & dcol, std::vector<long> & fcol) const
+{
+	size_t num_dcol = 0, num_fcol = 0;
+	while (true) {
+
+		// New factor colors from the colors of the attached dummy indices
+		std::vector<color_signature> fsig(factors.size());
+		for (size_t f=0; f<factors.size(); ++f) {
+			std::vector<color_signature> attached;
+			for (auto & s : slots[f])
+				if (s.dummy >= 0)
+					attached.push_back(color_signature{(long)s.orbit, s.deco, dcol[s.dummy]});
+			std::sort(attached.begin(), attached.end());
+			fsig[f].push_back(fcol[f]);
+			for (auto & a : attached)
+				fsig[f].insert(fsig[f].end(), a.begin(), a.end());
+		}
+		size_t new_num_fcol = rank_signatures(fsig, fcol);
+
+		// New dummy colors from the colors of the factors they connect
+		std::vector<color_signature> dsig(dummy_syms.size());
+		for (size_t d=0; d<dummy_syms.size(); ++d) {
+			std::vector<color_signature> ends;
+			for (auto & o : occurrences[d]) {
+				const slot_info & s = slots[o.first][o.second];
+				ends.push_back(color_signature{fcol[o.first], (long)s.orbit, s.deco});
+			}
+			std::sort(ends.begin(), ends.end());
+			dsig[d].push_back(dcol[d]);
+			for (auto & a : ends)
+				dsig[d].insert(dsig[d].end(), a.begin(), a.end());
+		}
+		size_t new_num_dcol = rank_signatures(dsig, dcol);
+
+		if (new_num_dcol == num_dcol && new_num_fcol == num_fcol)
+			break;
+		num_dcol = new_num_dcol;
+		num_fcol = new_num_fcol;
+	}
+}
+
+/** Compute the word describing the product for a given labeling of the dummy
+ *  indices: the symmetry-canonicalized index codes of all factors, with the
+ *  commutative factors sorted. */
+std::vector<color_signature> dummy_labeler::word(const std::vector<long> & label) const
+{
+	std::vector<color_signature> comm, noncomm;
+	long free_offset = (long)dummy_syms.size() * num_deco;
+	for (size_t f=0; f<factors.size(); ++f) {
+		exvector codes;
+		codes.reserve(slots[f].size());
+		for (auto & s : slots[f])
+			codes.push_back(numeric(s.dummy >= 0 ? label[s.dummy] * num_deco + s.deco : free_offset + s.code));
+		if (codes.size() > 1)
+			canonicalize(codes.begin(), ex_to<symmetry>(ex_to<indexed>(factors[f]).get_symmetry()));
+
+		color_signature w{factor_nc[f], factor_key[f]};
+		for (auto & c : codes)
+			w.push_back(ex_to<numeric>(c).to_long());
+		if (factor_nc[f] < 0)
+			comm.push_back(w);
+		else
+			noncomm.push_back(w);
+	}
+	std::sort(comm.begin(), comm.end());
+	comm.insert(comm.end(), noncomm.begin(), noncomm.end());
+	return comm;
+}
+
+/** Refine the coloring, and either evaluate the resulting labeling (if all
+ *  dummy indices are distinguished) or branch on all possible choices of
+ *  the first ambiguous dummy index. */
+void dummy_labeler::search(std::vector<long> dcol, std::vector<long> fcol)
+{
+	if (num_leaves >= max_dummy_labelings)
+		return;
+
+	refine(dcol, fcol);
+
+	// Find the first color class with more than one dummy index
+	std::map<long, size_t> class_size;
+	for (auto & c : dcol)
+		++class_size[c];
+	long target = -1;
+	for (auto & it : class_size) {
+		if (it.second > 1) {
+			target = it.first;
+			break;
+		}
+	}
+
+	if (target < 0) {
+
+		// Discrete coloring, the colors are the labels
+		++num_leaves;
+		std::vector<color_signature> w = word(dcol);
+		if (best_label.empty() || w < best_word) {
+			best_word.swap(w);
+			best_label = dcol;
+		}
+		return;
+	}
+
+	// Individualize each candidate in turn
+	for (size_t d=0; d<dcol.size(); ++d) {
+		if (dcol[d] != target)
+			continue;
+		std::vector<long> new_dcol(dcol.size());
+		for (size_t i=0; i<dcol.size(); ++i)
+			new_dcol[i] = 2 * dcol[i];
+		new_dcol[d] = 2 * target - 1;
+		search(new_dcol, fcol);
+	}
+}
+
+ex dummy_labeler::relabel()
+{
+	if (!ok)
+		return orig;
+
+	// Initial colors: decorations of dummy indices, keys of factors
+	std::vector<long> dcol(dummy_syms.size());
+	for (size_t d=0; d<dummy_syms.size(); ++d) {
+		color_signature ends;
+		for (auto & o : occurrences[d])
+			ends.push_back(slots[o.first][o.second].deco);
+		std::sort(ends.begin(), ends.end());
+		dcol[d] = ends[0] * num_deco + ends[1];
+	}
+	std::vector<long> fcol(factors.size());
+	std::vector<color_signature> fsig;
+	for (size_t f=0; f<factors.size(); ++f)
+		fsig.push_back(color_signature{factor_nc[f], factor_key[f]});
+	rank_signatures(fsig, fcol);
+	search(dcol, fcol);
+
+	// Within each index class, the dummy index with the smallest label gets
+	// the smallest symbol
+	std::map<std::string, std::vector<std::pair<long, ex>>> by_class;
+	for (size_t d=0; d<dummy_syms.size(); ++d)
+		by_class[dummy_class[d]].push_back(std::make_pair(best_label[d], dummy_syms[d]));
+	exmap m;
+	for (auto & it : by_class) {
+		std::vector<std::pair<long, ex>> & labeled = it.second;
+		std::sort(labeled.begin(), labeled.end(),
+		          [](const std::pair<long, ex> & a, const std::pair<long, ex> & b) { return a.first < b.first; });
+		exvector syms;
+		for (auto & l : labeled)
+			syms.push_back(l.second);
+		std::sort(syms.begin(), syms.end(), ex_is_less());
+		for (size_t i=0; i<syms.size(); ++i)
+			if (!labeled[i].second.is_equal(syms[i]))
+				m[labeled[i].second] = syms[i];
+	}
+	if (m.empty())
+		return orig;
+	return orig.subs(m, subs_options::no_pattern);
+}
+
+/** Rename the dummy indices of a product of indexed objects canonically.
+ *  The set of dummy index symbols is not changed, only their assignment to
+ *  the index pairs, so products that are equal up to dummy index renaming
+ *  and symmetries of the factors become identical. */
+static ex canonicalize_dummy_indices(const ex & e)
+{
+	if (!is_a<indexed>(e) && !is_exactly_a<mul>(e) && !is_exactly_a<ncmul>(e)
+	 && !(is_exactly_a<power>(e) && is_a<indexed>(e.op(0)) && e.op(1).is_equal(_ex2)))
+		return e;
+	return dummy_labeler(e).relabel();
+}
+
 // Forward declaration needed in absence of friend injection, C.f. [namespace.memdef]:
 ex simplify_indexed(const ex & e, exvector & free_indices, exvector & dummy_indices, const scalar_products & sp);
 
@@ -786,8 +1169,47 @@ ex simplify_indexed_product(const ex & e, exvector & free_indices, exvector & du
 	bool non_commutative;
 	product_to_exvector(e, v, non_commutative);
 
-	// Perform contractions
 	bool something_changed = false;
+
+	// Replace all known scalar products of vectors in one pass. Vectors (objects
+	// with a single index) are paired up by the symbol of their index.
+	if (!sp.empty()) {
+		bool reexpand = false;
+		exhashmap<size_t> unpaired;
+		for (size_t k=0; k<v.size(); ++k) {
+			if (!is_a<indexed>(v[k]) || v[k].nops() != 2)
+				continue;
+			const ex & i = v[k].op(1);
+			auto it = unpaired.find(i.op(0));
+			if (it == unpaired.end()) {
+				unpaired.insert(std::make_pair(i.op(0), k));
+				continue;
+			}
+			ex & other = v[it->second];
+			unpaired.erase(it);
+			if (!is_dummy_pair(other.op(1), i))
+				continue;
+			const ex * value = sp.find(other, v[k], minimal_dim(ex_to<idx>(other.op(1)).get_dim(), ex_to<idx>(i).get_dim()));
+			if (value) {
+				if (other.return_type() != return_types::commutative || v[k].return_type() != return_types::commutative)
+					reexpand = true;
+				other = *value;
+				v[k] = _ex1;
+				something_changed = true;
+				if (is_exactly_a<add>(other) || is_exactly_a<mul>(other) || is_exactly_a<ncmul>(other))
+					reexpand = true;
+			}
+		}
+
+		// If a scalar product was replaced by a sum or product, or the product
+		// was noncommutative, the expression has to be expanded again
+		if (reexpand) {
+			ex r = (non_commutative ? ex(ncmul(std::move(v))) : ex(mul(std::move(v))));
+			return simplify_indexed(r, free_indices, dummy_indices, sp);
+		}
+	}
+
+	// Perform contractions
 	bool has_nonsymmetric = false;
 	GINAC_ASSERT(v.size() > 1);
 	exvector::iterator it1, itend = v.end(), next_to_last = itend - 1;
@@ -836,10 +1258,11 @@ try_again:
 				);
 
 				// User-defined scalar product?
-				if (sp.is_defined(*it1, *it2, dim)) {
+				const ex * value = sp.find(*it1, *it2, dim);
+				if (value) {
 
 					// Yes, substitute it
-					*it1 = sp.evaluate(*it1, *it2, dim);
+					*it1 = *value;
 					*it2 = _ex1;
 					goto contraction_done;
 				}
@@ -1029,6 +1452,53 @@ public:
 	}
 };
 
+/** This class accumulates the simplified terms of a sum. Terms that only
+ *  differ by a numeric coefficient are combined on the fly, using a hash
+ *  table keyed by the term without its coefficient, so that the final sum is
+ *  constructed only once instead of being rebuilt for every term. */
+class term_combiner {
+public:
+	/** Add a term. */
+	void add_term(const ex & term)
+	{
+		if (is_exactly_a<add>(term)) {
+			for (const auto & t : term)
+				add_term(t);
+			return;
+		}
+
+		ex rest = term, coeff = _ex1;
+		if (is_exactly_a<mul>(term) && is_exactly_a<numeric>(term.op(term.nops()-1))) {
+			coeff = term.op(term.nops()-1);
+			rest = term / coeff;
+		} else if (is_exactly_a<numeric>(term)) {
+			rest = _ex1;
+			coeff = term;
+		}
+		auto it = position.find(rest);
+		if (it == position.end()) {
+			position.insert(std::make_pair(rest, terms.size()));
+			terms.push_back(std::make_pair(rest, coeff));
+		} else
+			terms[it->second].second += coeff;
+	}
+
+	/** Return the sum of all terms added so far. */
+	ex sum() const
+	{
+		exvector v;
+		v.reserve(terms.size());
+		for (auto & t : terms)
+			if (!t.second.is_zero())
+				v.push_back(t.first * t.second);
+		return dynallocate<add>(v);
+	}
+
+private:
+	std::vector<std::pair<ex, ex>> terms;  /**< (term without coefficient, coefficient) */
+	exhashmap<size_t> position;            /**< position of term in "terms" */
+};
+
 bool hasindex(const ex &x, const ex &sym)
 {	
 	if(is_a<idx>(x) && x.op(0)==sym)
@@ -1079,11 +1549,18 @@ ex simplify_indexed(const ex & e, exvector & free_indices, exvector & dummy_indi
 	if (is_exactly_a<add>(e_expanded)) {
 		bool first = true;
 		ex sum;
+		term_combiner combined;
 		free_indices.clear();
 
 		for (size_t i=0; i<e_expanded.nops(); i++) {
 			exvector free_indices_of_term;
 			ex term = simplify_indexed(e_expanded.op(i), free_indices_of_term, dummy_indices, sp);
+
+			// Canonicalize the dummy index names, so that terms that only
+			// differ by renaming of dummy indices combine automatically
+			if (!term.is_zero())
+				term = canonicalize_dummy_indices(term);
+
 			if (!term.is_zero()) {
 				if (first) {
 					free_indices = free_indices_of_term;
@@ -1096,13 +1573,24 @@ ex simplify_indexed(const ex & e, exvector & free_indices, exvector & dummy_indi
 						s << exprseq(free_indices) << " vs. " << exprseq(free_indices_of_term);
 						throw (std::runtime_error(s.str()));
 					}
-					if (is_a<indexed>(sum) && is_a<indexed>(term))
+					if (is_a<indexed>(sum) && is_a<indexed>(term)) {
 						sum = ex_to<basic>(sum.op(0)).add_indexed(sum, term);
-					else
-						sum += term;
+						if (!is_a<indexed>(sum)) {
+							combined.add_term(sum);
+							sum = _ex0;
+						}
+					} else if (sum.is_zero())
+						combined.add_term(term);
+					else {
+						combined.add_term(sum);
+						combined.add_term(term);
+						sum = _ex0;
+					}
 				}
 			}
 		}
+		if (!first && sum.is_zero())
+			sum = combined.sum();
 
 		// If the sum turns out to be zero, we are finished
 		if (sum.is_zero()) {
@@ -1340,6 +1828,16 @@ bool spmapkey::operator<(const spmapkey &other) const
 		return dim.compare(other.dim) < 0;
 }
 
+bool spmapkey::is_identical(const spmapkey &other) const
+{
+	return v1.is_equal(other.v1) && v2.is_equal(other.v2) && dim.is_equal(other.dim);
+}
+
+unsigned spmapkey::hash() const
+{
+	return rotate_left(v1.gethash()) ^ v2.gethash();
+}
+
 void spmapkey::debugprint() const
 {
 	std::cerr << "(" << v1 << "," << v2 << "," << dim << ")";
@@ -1368,16 +1866,35 @@ void scalar_products::clear()
 	spm.clear();
 }
 
+const ex * scalar_products::find(const ex & v1, const ex & v2, const ex & dim) const
+{
+	if (spm.empty())
+		return nullptr;
+
+	spmapkey k(v1, v2, dim);
+	auto it = spm.find(k);
+	if (it != spm.end())
+		return &it->second;
+
+	// No entry for exactly this dimension. All entries for the pair of
+	// vectors share one bucket, so look there for a matching wildcard.
+	size_t b = spm.bucket(k);
+	for (auto i = spm.begin(b); i != spm.end(b); ++i)
+		if (i->first == k)
+			return &i->second;
+	return nullptr;
+}
+
 /** Check whether scalar product pair is defined. */
 bool scalar_products::is_defined(const ex & v1, const ex & v2, const ex & dim) const
 {
-	return spm.find(spmapkey(v1, v2, dim)) != spm.end();
+	return find(v1, v2, dim) != nullptr;
 }
 
 /** Return value of defined scalar product pair. */
 ex scalar_products::evaluate(const ex & v1, const ex & v2, const ex & dim) const
 {
-	return spm.find(spmapkey(v1, v2, dim))->second;
+	return *find(v1, v2, dim);
 }
 
 void scalar_products::debugprint() const
@@ -1575,4 +2092,347 @@ ex expand_dummy_sum(const ex & e, bool subs_idx)
 	}
 }
 
+
+/** Dense array of the numeric components of an indexed expression, used by
+ *  eval_components(). The axes are labelled by index values and the
+ *  components are stored in row-major order (last axis varies fastest). */
+struct dense_components {
+	exvector axes;
+	std::vector<size_t> dims;
+	std::vector<numeric> data;
+
+	dense_components() : data(1, *_num0_p) {}
+	explicit dense_components(const numeric & x) : data(1, x) {}
+};
+
+typedef std::map<ex, size_t, ex_is_less> index_dim_map;
+
+/** Find the dimensions of all symbolic indices in an expression. Indices
+ *  with the same value but different dimensions get the smallest one. */
+static void collect_index_dims(const ex & e, index_dim_map & dims)
+{
+	if (is_a<idx>(e)) {
+		const ex & value = ex_to<idx>(e).get_value();
+		if (is_a<numeric>(value))
+			return;
+		const ex & dim = ex_to<idx>(e).get_dim();
+		if (!dim.info(info_flags::nonnegint)) {
+			std::ostringstream s;
+			s << "eval_components(): dimension of index " << e << " is not numeric";
+			throw (std::invalid_argument(s.str()));
+		}
+		size_t d = ex_to<numeric>(dim).to_int();
+		auto it = dims.find(value);
+		if (it == dims.end())
+			dims.insert(std::make_pair(value, d));
+		else if (d < it->second)
+			it->second = d;
+		return;
+	}
+	for (size_t i=0; i<e.nops(); ++i)
+		collect_index_dims(e.op(i), dims);
+}
+
+static numeric component_to_numeric(const ex & e)
+{
+	if (is_a<numeric>(e))
+		return ex_to<numeric>(e);
+	ex f = e.evalf();
+	if (is_a<numeric>(f))
+		return ex_to<numeric>(f);
+	std::ostringstream s;
+	s << "eval_components(): component " << e << " is not numeric";
+	throw (std::invalid_argument(s.str()));
+}
+
+static size_t axis_position(const exvector & axes, const ex & a)
+{
+	for (size_t k=0; k<axes.size(); ++k)
+		if (axes[k].is_equal(a))
+			return k;
+	return axes.size();
+}
+
+/** Rearrange the components so that the axes come in the given order. */
+static dense_components dense_transpose(const dense_components & t, const exvector & axes)
+{
+	const size_t rank = axes.size();
+	if (rank != t.axes.size())
+		throw (std::invalid_argument("eval_components(): inconsistent indices"));
+	bool same = true;
+	for (size_t k=0; k<rank; ++k)
+		if (!axes[k].is_equal(t.axes[k]))
+			same = false;
+	if (same)
+		return t;
+
+	std::vector<size_t> stride(rank), src_stride(rank);
+	size_t s = 1;
+	for (size_t k=rank; k-- > 0; ) {
+		src_stride[k] = s;
+		s *= t.dims[k];
+	}
+
+	dense_components r;
+	r.axes = axes;
+	r.dims.resize(rank);
+	for (size_t k=0; k<rank; ++k) {
+		size_t pos = axis_position(t.axes, axes[k]);
+		if (pos == rank)
+			throw (std::invalid_argument("eval_components(): inconsistent indices"));
+		r.dims[k] = t.dims[pos];
+		stride[k] = src_stride[pos];
+	}
+	r.data.resize(t.data.size());
+
+	// Walk through the result in storage order, keeping track of the
+	// position in the source
+	std::vector<size_t> counter(rank, 0);
+	size_t src = 0;
+	for (size_t n=0; n<r.data.size(); ++n) {
+		r.data[n] = t.data[src];
+		for (size_t k=rank; k-- > 0; ) {
+			if (++counter[k] < r.dims[k]) {
+				src += stride[k];
+				break;
+			}
+			src -= stride[k] * (r.dims[k] - 1);
+			counter[k] = 0;
+		}
+	}
+	return r;
+}
+
+/** Contract two arrays over all axes they have in common (outer product if
+ *  there are none). Both arrays are rearranged so that the contraction
+ *  becomes a matrix product, which is computed row by row so that the
+ *  innermost loop runs over contiguous memory. */
+static dense_components dense_contract(const dense_components & a, const dense_components & b)
+{
+	exvector a_free, common, b_free;
+	size_t a_size = 1, common_size = 1, b_size = 1;
+	std::vector<size_t> a_free_dims, b_free_dims;
+	for (size_t k=0; k<a.axes.size(); ++k) {
+		size_t pos = axis_position(b.axes, a.axes[k]);
+		if (pos == b.axes.size()) {
+			a_free.push_back(a.axes[k]);
+			a_free_dims.push_back(a.dims[k]);
+			a_size *= a.dims[k];
+		} else {
+			common.push_back(a.axes[k]);
+			common_size *= a.dims[k];
+		}
+	}
+	for (size_t k=0; k<b.axes.size(); ++k) {
+		if (axis_position(a.axes, b.axes[k]) == a.axes.size()) {
+			b_free.push_back(b.axes[k]);
+			b_free_dims.push_back(b.dims[k]);
+			b_size *= b.dims[k];
+		}
+	}
+
+	exvector a_order(a_free);
+	a_order.insert(a_order.end(), common.begin(), common.end());
+	exvector b_order(common);
+	b_order.insert(b_order.end(), b_free.begin(), b_free.end());
+	const dense_components at = dense_transpose(a, a_order);
+	const dense_components bt = dense_transpose(b, b_order);
+
+	dense_components r;
+	r.axes = a_free;
+	r.axes.insert(r.axes.end(), b_free.begin(), b_free.end());
+	r.dims = a_free_dims;
+	r.dims.insert(r.dims.end(), b_free_dims.begin(), b_free_dims.end());
+	r.data.assign(a_size * b_size, *_num0_p);
+
+	for (size_t i=0; i<a_size; ++i) {
+		numeric * row = &r.data[i * b_size];
+		for (size_t k=0; k<common_size; ++k) {
+			const numeric & aik = at.data[i * common_size + k];
+			if (aik.is_zero())
+				continue;
+			const numeric * bk = &bt.data[k * b_size];
+			for (size_t j=0; j<b_size; ++j)
+				row[j] += aik * bk[j];
+		}
+	}
+	return r;
+}
+
+/** Sum over the given axis. */
+static dense_components dense_trace(const dense_components & t, const ex & axis)
+{
+	exvector order;
+	for (auto & a : t.axes)
+		if (!a.is_equal(axis))
+			order.push_back(a);
+	order.push_back(axis);
+	const dense_components tt = dense_transpose(t, order);
+
+	dense_components r;
+	r.axes.assign(order.begin(), order.end() - 1);
+	r.dims.assign(tt.dims.begin(), tt.dims.end() - 1);
+	const size_t n = tt.dims.back();
+	r.data.resize(tt.data.size() / n);
+	for (size_t i=0; i<r.data.size(); ++i) {
+		numeric sum = *_num0_p;
+		for (size_t k=0; k<n; ++k)
+			sum += tt.data[i * n + k];
+		r.data[i] = sum;
+	}
+	return r;
+}
+
+/** Components of a single indexed object. */
+static dense_components dense_indexed(const indexed & e, const index_dim_map & dims)
+{
+	dense_components r;
+	exvector repeated;
+	for (size_t i=1; i<e.nops(); ++i) {
+		const ex & value = ex_to<idx>(e.op(i)).get_value();
+		if (is_a<numeric>(value))
+			continue;
+		if (axis_position(r.axes, value) < r.axes.size()) {
+			repeated.push_back(value);
+			continue;
+		}
+		r.axes.push_back(value);
+		r.dims.push_back(dims.find(value)->second);
+	}
+
+	size_t total = 1;
+	for (auto d : r.dims)
+		total *= d;
+	r.data.resize(total);
+
+	// Matrices are read directly
+	const ex & base = e.op(0);
+	if (is_a<matrix>(base) && repeated.empty() && r.axes.size() == e.nops() - 1) {
+		const matrix & m = ex_to<matrix>(base);
+		if (r.axes.size() == 2 && m.rows() == r.dims[0] && m.cols() == r.dims[1]) {
+			for (unsigned i=0; i<m.rows(); ++i)
+				for (unsigned j=0; j<m.cols(); ++j)
+					r.data[i * m.cols() + j] = component_to_numeric(m(i, j));
+			return r;
+		}
+		if (r.axes.size() == 1 && (m.rows() == 1 || m.cols() == 1) && m.nops() == r.dims[0]) {
+			for (size_t i=0; i<total; ++i)
+				r.data[i] = component_to_numeric(m.op(i));
+			return r;
+		}
+	}
+
+	// Everything else is evaluated with numeric index values
+	exmap m;
+	std::vector<size_t> counter(r.axes.size(), 0);
+	for (size_t n=0; n<total; ++n) {
+		for (size_t k=0; k<r.axes.size(); ++k)
+			m[r.axes[k]] = numeric(counter[k]);
+		r.data[n] = component_to_numeric(ex(e).subs(m, subs_options::no_pattern|subs_options::no_index_renaming));
+		for (size_t k=r.axes.size(); k-- > 0; ) {
+			if (++counter[k] < r.dims[k])
+				break;
+			counter[k] = 0;
+		}
+	}
+
+	for (auto & a : repeated)
+		r = dense_trace(r, a);
+	return r;
+}
+
+static dense_components dense_eval(const ex & e, const index_dim_map & dims)
+{
+	if (is_a<indexed>(e)) {
+		return dense_indexed(ex_to<indexed>(e), dims);
+
+	} else if (is_exactly_a<add>(e)) {
+		dense_components r = dense_eval(e.op(0), dims);
+		for (size_t i=1; i<e.nops(); ++i) {
+			dense_components t = dense_transpose(dense_eval(e.op(i), dims), r.axes);
+			for (size_t n=0; n<r.data.size(); ++n)
+				r.data[n] += t.data[n];
+		}
+		return r;
+
+	} else if (is_exactly_a<mul>(e)) {
+		numeric coeff = *_num1_p;
+		std::vector<dense_components> factors;
+		for (size_t i=0; i<e.nops(); ++i) {
+			dense_components t = dense_eval(e.op(i), dims);
+			if (t.axes.empty())
+				coeff *= t.data[0];
+			else
+				factors.push_back(std::move(t));
+		}
+
+		// Contract the pair of arrays with the smallest result first
+		while (factors.size() > 1) {
+			size_t best_i = 0, best_j = 1, best_size = std::numeric_limits<size_t>::max();
+			for (size_t i=0; i<factors.size(); ++i) {
+				for (size_t j=i+1; j<factors.size(); ++j) {
+					size_t size = 1;
+					bool shared = false;
+					for (size_t k=0; k<factors[i].axes.size(); ++k) {
+						if (axis_position(factors[j].axes, factors[i].axes[k]) < factors[j].axes.size())
+							shared = true;
+						else
+							size *= factors[i].dims[k];
+					}
+					for (size_t k=0; k<factors[j].axes.size(); ++k)
+						if (axis_position(factors[i].axes, factors[j].axes[k]) == factors[i].axes.size())
+							size *= factors[j].dims[k];
+					if (shared && size < best_size) {
+						best_i = i;
+						best_j = j;
+						best_size = size;
+					}
+				}
+			}
+			factors[best_i] = dense_contract(factors[best_i], factors[best_j]);
+			factors.erase(factors.begin() + best_j);
+		}
+
+		if (factors.empty())
+			return dense_components(coeff);
+		if (!coeff.is_equal(*_num1_p))
+			for (auto & x : factors[0].data)
+				x *= coeff;
+		return factors[0];
+
+	} else if (is_exactly_a<power>(e) && e.op(1).info(info_flags::nonnegint)) {
+		const ex & base = e.op(0);
+		if (!base.get_free_indices().empty()) {
+			if (!e.op(1).is_equal(_ex2))
+				throw (std::invalid_argument("eval_components(): illegal power of indexed expression"));
+			dense_components t = dense_eval(base, dims);
+			return dense_contract(t, t);
+		}
+		return dense_components(dense_eval(base, dims).data[0].power(ex_to<numeric>(e.op(1))));
+
+	} else if (is_exactly_a<ncmul>(e)) {
+		throw (std::invalid_argument("eval_components(): noncommutative products are not supported"));
+	}
+
+	return dense_components(component_to_numeric(e));
+}
+
+std::vector<numeric> eval_components(const ex & e, const exvector & free_indices)
+{
+	index_dim_map dims;
+	collect_index_dims(e, dims);
+	for (auto & i : free_indices) {
+		if (!is_a<idx>(i))
+			throw (std::invalid_argument("eval_components(): free indices must be of type idx"));
+		collect_index_dims(i, dims);
+	}
+
+	exvector axes;
+	for (auto & i : free_indices)
+		axes.push_back(ex_to<idx>(i).get_value());
+
+	dense_components r = dense_transpose(dense_eval(e, dims), axes);
+	return std::move(r.data);
+}
+
 } // namespace GiNaC
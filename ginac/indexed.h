@@ -26,10 +26,11 @@
 #include "exprseq.h"
 #include "wildcard.h"
 
-#include <map>
+#include <unordered_map>
 
 namespace GiNaC {
 
+class numeric;
 class scalar_products;
 class symmetry;
 
@@ -202,13 +203,29 @@ public:
 	bool operator==(const spmapkey &other) const;
 	bool operator<(const spmapkey &other) const;
 
+	/** Check whether two keys are identical (a wildcard dimension only
+	 *  matches a wildcard dimension). */
+	bool is_identical(const spmapkey &other) const;
+
+	/** Hash value of the pair of vectors. The dimension does not enter, so
+	 *  all entries for a pair end up in the same bucket. */
+	unsigned hash() const;
+
 	void debugprint() const;
 
 protected:
 	ex v1, v2, dim;
 };
 
-typedef std::map<spmapkey, ex> spmap;
+struct spmapkey_hash {
+	std::size_t operator()(const spmapkey & k) const { return k.hash(); }
+};
+
+struct spmapkey_is_identical {
+	bool operator()(const spmapkey & k1, const spmapkey & k2) const { return k1.is_identical(k2); }
+};
+
+typedef std::unordered_map<spmapkey, ex, spmapkey_hash, spmapkey_is_identical> spmap;
 
 /** Helper class for storing information about known scalar products which
  *  are to be automatically replaced by simplify_indexed().
@@ -230,8 +247,18 @@ public:
 	/** Clear all registered scalar products. */
 	void clear();
 
+	/** Check whether no scalar products are registered. */
+	bool empty() const { return spm.empty(); }
+
 	bool is_defined(const ex & v1, const ex & v2, const ex & dim) const;
 	ex evaluate(const ex & v1, const ex & v2, const ex & dim) const;
+
+	/** Look up scalar product pair. An entry for the given dimension takes
+	 *  precedence over an entry registered for any dimension.
+	 *
+	 *  @return pointer to the value, or nullptr if the pair is not defined */
+	const ex * find(const ex & v1, const ex & v2, const ex & dim) const;
+
 	void debugprint() const;
 
 protected:
@@ -273,6 +300,20 @@ lst rename_dummy_indices_uniquely(const exvector & va, const exvector & vb);
  */
 ex expand_dummy_sum(const ex & e, bool subs_idx = false);
 
+/** This function evaluates all components of an indexed expression to
+ *  numbers, without expanding the dummy index summations symbolically.
+ *  Contractions are computed numerically on dense arrays. The expression may
+ *  contain sums and products of indexed objects with a matrix as base or
+ *  any other base that evaluates to numbers for numeric index values, such
+ *  as the delta, metric and epsilon tensors. All symbolic indices must have
+ *  a numeric dimension.
+ *
+ *  @param e the given expression
+ *  @param free_indices the free indices of e, in the order in which they
+ *         enumerate the components
+ *  @return the components, the last index varying fastest */
+std::vector<numeric> eval_components(const ex & e, const exvector & free_indices);
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_INDEXED_H
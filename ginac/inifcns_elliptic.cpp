@@ -339,6 +339,14 @@ REGISTER_FUNCTION(EllipticE,
 namespace {
 
 // performs the actual series summation for an iterated integral
+//
+// The term of order N is lambda^N / N^m[0] * T[0](N), where
+//   T[depth-1](n) = c[depth-1](n),
+//   T[j-1](n)     = sum_{i=1}^{n} c[j-1](n-i) T[j](i) / i^m[j],
+// and c[j](n) is the n-th series coefficient of kernel j.  The values
+// U[j](i) = T[j](i) / i^m[j] and the coefficients are kept in arrays, so
+// that going from order N-1 to N costs O(depth*N) operations instead of a
+// sum over all ordered multi-indices of length depth-1.
 cln::cl_N iterated_integral_do_sum(const std::vector<int> & m, const std::vector<const integration_kernel *> & kernel, const cln::cl_N & lambda, int N_trunc)
 {
         if ( cln::zerop(lambda) ) {
@@ -349,71 +357,39 @@ cln::cl_N iterated_integral_do_sum(const std::vector<int> & m, const std::vector
 
 	const int depth = m.size();
 
+	std::vector<std::vector<cln::cl_N>> c(depth), U(depth);
+	for (int j=0; j<depth; j++) {
+		c[j].push_back(kernel[j]->series_coeff(0));
+		U[j].push_back(0);
+	}
+
 	cln::cl_N res = 0;
 	cln::cl_N resbuf;
 	cln::cl_N subexpr;
+	cln::cl_N lambda_N = one;
 
-	if ( N_trunc == 0 ) {
-		// sum until precision is reached
-		bool flag_accidental_zero = false;
-
-		int N = 1;
-
-		do {
-			resbuf = res;
-
-			if ( depth > 1 ) {
-				subexpr = 0;
-				multi_iterator_ordered_eq<int> i_multi(1,N+1,depth-1);
-				for( i_multi.init(); !i_multi.overflow(); i_multi++) {
-					cln::cl_N tt = one;
-					for (int j=1; j<depth; j++) {
-						if ( j==1 ) {
-							tt = tt * kernel[0]->series_coeff(N-i_multi[depth-2]) / cln::expt(cln::cl_I(i_multi[depth-2]),m[1]);
-						}
-						else {
-							tt = tt * kernel[j-1]->series_coeff(i_multi[depth-j]-i_multi[depth-j-1]) / cln::expt(cln::cl_I(i_multi[depth-j-1]),m[j]);
-						}
-					}
-					tt = tt * kernel[depth-1]->series_coeff(i_multi[0]);
-					subexpr += tt;
-				}
-			}
-			else {
-				// depth == 1
-				subexpr = kernel[0]->series_coeff(N) * one;
-			}
-			flag_accidental_zero = cln::zerop(subexpr);
-			res += cln::expt(lambda, N) / cln::expt(cln::cl_I(N),m[0]) * subexpr;
-			N++;
+	for (int N=1; (N_trunc == 0) || (N<=N_trunc); N++) {
+		resbuf = res;
 
-		} while ( (res != resbuf) || flag_accidental_zero );
-	}
-	else {
-		// N_trunc > 0, sum up the first N_trunc terms
-		for (int N=1; N<=N_trunc; N++) {
-			if ( depth > 1 ) {
-				subexpr = 0;
-				multi_iterator_ordered_eq<int> i_multi(1,N+1,depth-1);
-				for( i_multi.init(); !i_multi.overflow(); i_multi++) {
-					cln::cl_N tt = one;
-					for (int j=1; j<depth; j++) {
-						if ( j==1 ) {
-							tt = tt * kernel[0]->series_coeff(N-i_multi[depth-2]) / cln::expt(cln::cl_I(i_multi[depth-2]),m[1]);
-						}
-						else {
-							tt = tt * kernel[j-1]->series_coeff(i_multi[depth-j]-i_multi[depth-j-1]) / cln::expt(cln::cl_I(i_multi[depth-j-1]),m[j]);
-						}
-					}
-					tt = tt * kernel[depth-1]->series_coeff(i_multi[0]);
-					subexpr += tt;
-				}
-			}
-			else {
-				// depth == 1
-				subexpr = kernel[0]->series_coeff(N) * one;
+		for (int j=0; j<depth; j++) {
+			c[j].push_back(kernel[j]->series_coeff(N));
+		}
+
+		subexpr = c[depth-1][N] * one;
+		for (int j=depth-1; j>0; j--) {
+			U[j].push_back(subexpr / cln::expt(cln::cl_I(N),m[j]));
+			subexpr = 0;
+			for (int i=1; i<=N; i++) {
+				subexpr += c[j-1][N-i] * U[j][i];
 			}
-			res += cln::expt(lambda, N) / cln::expt(cln::cl_I(N),m[0]) * subexpr;
+		}
+
+		lambda_N = lambda_N * lambda;
+		res += lambda_N / cln::expt(cln::cl_I(N),m[0]) * subexpr;
+
+		// sum until precision is reached
+		if ( (N_trunc == 0) && (res == resbuf) && !cln::zerop(subexpr) ) {
+			break;
 		}
 	}
 
@@ -33,6 +33,14 @@
 #include "utils.h"
 #include "operators.h"
 #include "relational.h"
+#include "constant.h"
+#include "hash_map.h"
+
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
 
 using namespace std;
 
@@ -163,9 +171,17 @@ ex integral::evalf() const
 
 	// 12.34 is just an arbitrary number used to check whether a number
 	// results after substituting a number for the integration variable.
-	if (is_exactly_a<numeric>(ea) && is_exactly_a<numeric>(eb) &&
-	    is_exactly_a<numeric>(ef.subs(x==12.34).evalf())) {
-			return adaptivesimpson(x, ea, eb, ef);
+	if (is_exactly_a<numeric>(ea) && is_exactly_a<numeric>(eb)) {
+		// Nested integrals are done in one multidimensional cubature. If
+		// the integrand does not evaluate to a number, the check below
+		// decides what to return.
+		if (is_exactly_a<integral>(ef)) {
+			try {
+				return adaptivecubature(dynallocate<integral>(x, ea, eb, ef));
+			} catch (const logic_error &) { }
+		}
+		if (is_exactly_a<numeric>(ef.subs(x==12.34).evalf()))
+			return doubleexponential(x, ea, eb, ef);
 	}
 
 	if (are_ex_trivially_equal(a, ea) && are_ex_trivially_equal(b, eb) &&
@@ -299,6 +315,598 @@ ex adaptivesimpson(const ex & x, const ex & a_in, const ex & b_in, const ex & f,
 	return app;
 }
 
+/** The integrand, lowered once to a list of numeric operations on its
+ *  distinct subexpressions.  Evaluating it at a sample point then costs
+ *  neither a subs() nor a rebuild of the expression tree.  Subexpressions
+ *  not depending on the integration variables are evaluated only once. */
+class numeric_integrand {
+public:
+	numeric_integrand(const exvector & vars, const ex & f);
+
+	/** Value of the integrand for the given values of the variables. */
+	numeric operator()(const std::vector<numeric> & values) const;
+
+	/** Value of the integrand of a one-dimensional integral. */
+	numeric operator()(const numeric & value) const
+	{
+		return (*this)(std::vector<numeric>(1, value));
+	}
+
+private:
+	enum opcode { op_const, op_var, op_add, op_mul, op_power, op_function, op_generic, op_symbolic };
+	typedef const numeric (*numeric_function)(const numeric &);
+
+	struct instr {
+		opcode code;
+		std::vector<size_t> args;
+		numeric value;
+		numeric_function fn = nullptr;
+		ex e;
+		bool variable = false;  ///< e depends on the integration variables
+	};
+
+	size_t lower(const ex & e, exhashmap<size_t> & seen);
+	static numeric_function elementary_function(const ex & e);
+
+	exvector vars;
+	std::vector<instr> code;
+	size_t root;
+};
+
+numeric_integrand::numeric_integrand(const exvector & vars_, const ex & f) : vars(vars_)
+{
+	exhashmap<size_t> seen;
+	root = lower(f, seen);
+	if (code[root].code == op_symbolic)
+		code[root].code = op_generic;
+}
+
+/** Returns the numeric function for the elementary functions of one
+ *  argument, or nullptr. */
+numeric_integrand::numeric_function numeric_integrand::elementary_function(const ex & e)
+{
+	if (e.nops() != 1)
+		return nullptr;
+	if (is_ex_the_function(e, exp))   return exp;
+	if (is_ex_the_function(e, log))   return log;
+	if (is_ex_the_function(e, sin))   return sin;
+	if (is_ex_the_function(e, cos))   return cos;
+	if (is_ex_the_function(e, tan))   return tan;
+	if (is_ex_the_function(e, asin))  return asin;
+	if (is_ex_the_function(e, acos))  return acos;
+	if (is_ex_the_function(e, atan))  return atan;
+	if (is_ex_the_function(e, sinh))  return sinh;
+	if (is_ex_the_function(e, cosh))  return cosh;
+	if (is_ex_the_function(e, tanh))  return tanh;
+	if (is_ex_the_function(e, asinh)) return asinh;
+	if (is_ex_the_function(e, acosh)) return acosh;
+	if (is_ex_the_function(e, atanh)) return atanh;
+	if (is_ex_the_function(e, abs))   return abs;
+	return nullptr;
+}
+
+size_t numeric_integrand::lower(const ex & e, exhashmap<size_t> & seen)
+{
+	auto found = seen.find(e);
+	if (found != seen.end())
+		return found->second;
+
+	instr in;
+	in.e = e;
+	bool depends = false;
+	if (is_a<symbol>(e)) {
+		for (size_t k = 0; k < vars.size(); ++k) {
+			if (e.is_equal(vars[k])) {
+				in.code = op_var;
+				in.args.push_back(k);
+				depends = true;
+				break;
+			}
+		}
+	} else if (is_a<lst>(e) || is_a<exprseq>(e)) {
+		// index lists of functions like H or G: never evaluated to a number
+		in.code = op_symbolic;
+		for (auto & v : vars) {
+			if (e.has(v)) {
+				in.variable = true;
+				break;
+			}
+		}
+		code.push_back(std::move(in));
+		return seen[e] = code.size() - 1;
+	} else if (is_exactly_a<add>(e) || is_exactly_a<mul>(e) ||
+	           is_exactly_a<power>(e) || is_a<function>(e)) {
+		bool symbolic_operand = false, variable_symbolic_operand = false;
+		for (size_t i = 0; i < e.nops(); ++i) {
+			size_t a = lower(e.op(i), seen);
+			in.args.push_back(a);
+			if (code[a].variable)
+				depends = true;
+			if (code[a].code == op_symbolic) {
+				symbolic_operand = true;
+				if (code[a].variable)
+					variable_symbolic_operand = true;
+			}
+		}
+		if (is_exactly_a<add>(e))
+			in.code = op_add;
+		else if (is_exactly_a<mul>(e))
+			in.code = op_mul;
+		else if (is_exactly_a<power>(e))
+			in.code = op_power;
+		else {
+			in.code = op_function;
+			in.fn = elementary_function(e);
+		}
+		// functions keep constant symbolic arguments as they are, anything
+		// else with symbolic operands is substituted into as a whole
+		if (symbolic_operand && (in.code != op_function || variable_symbolic_operand)) {
+			in.code = op_generic;
+			in.fn = nullptr;
+		}
+	} else {
+		for (auto & v : vars) {
+			if (e.has(v)) {
+				depends = true;
+				in.code = op_generic;
+				break;
+			}
+		}
+	}
+
+	in.variable = depends;
+	if (!depends) {
+		// constant: evaluate now, or keep it symbolic if this fails
+		ex c = e.evalf();
+		if (is_exactly_a<numeric>(c)) {
+			in.code = op_const;
+			in.value = ex_to<numeric>(c);
+		} else
+			in.code = op_symbolic;
+		in.args.clear();
+		in.fn = nullptr;
+	}
+
+	code.push_back(std::move(in));
+	return seen[e] = code.size() - 1;
+}
+
+numeric numeric_integrand::operator()(const std::vector<numeric> & values) const
+{
+	std::vector<numeric> reg(code.size());
+	for (size_t i = 0; i <= root; ++i) {
+		const instr & in = code[i];
+		switch (in.code) {
+		case op_const:
+			reg[i] = in.value;
+			break;
+		case op_var:
+			reg[i] = values[in.args[0]];
+			break;
+		case op_add: {
+			numeric sum;
+			for (auto a : in.args)
+				sum += reg[a];
+			reg[i] = sum;
+			break;
+		}
+		case op_mul: {
+			numeric prod = *_num1_p;
+			for (auto a : in.args)
+				prod *= reg[a];
+			reg[i] = prod;
+			break;
+		}
+		case op_power:
+			reg[i] = reg[in.args[0]].power(reg[in.args[1]]);
+			break;
+		case op_function:
+			if (in.fn) {
+				reg[i] = in.fn(reg[in.args[0]]);
+			} else {
+				ex f = in.e;
+				for (size_t k = 0; k < in.args.size(); ++k)
+					if (code[in.args[k]].code != op_symbolic)
+						f.let_op(k) = reg[in.args[k]];
+				ex r = f.eval().evalf();
+				if (!is_exactly_a<numeric>(r))
+					throw logic_error("integrand does not evaluate to numeric");
+				reg[i] = ex_to<numeric>(r);
+			}
+			break;
+		case op_generic: {
+			exmap m;
+			for (size_t k = 0; k < vars.size(); ++k)
+				m[vars[k]] = values[k];
+			ex r = in.e.subs(m).evalf();
+			if (!is_exactly_a<numeric>(r))
+				throw logic_error("integrand does not evaluate to numeric");
+			reg[i] = ex_to<numeric>(r);
+			break;
+		}
+		case op_symbolic:
+			break;
+		}
+	}
+	return reg[root];
+}
+
+/** Tanh-sinh (double exponential) quadrature of f over [a,b].  The step
+ *  size is halved, reusing all previous samples, until two successive
+ *  approximations agree to the relative error.  The substitution
+ *  x = tanh(pi/2*sinh(t)) clusters the samples at the end points, so
+ *  integrable end point singularities are handled well.  All quantities
+ *  are computed with the current precision Digits.
+ *
+ *  @return false if the rule did not converge */
+static bool tanh_sinh(const numeric_integrand & f, const numeric & a, const numeric & b,
+                      const numeric & error, numeric & result)
+{
+	static const int max_level = 8;
+	const numeric eps = numeric(10).power(-long(Digits));
+	const numeric halfpi = ex_to<numeric>(Pi.evalf()) / 2;
+	const numeric d = (b - a) / 2;
+
+	// sum of w(t)*f(x(t)) over the samples and of the absolute values, for
+	// t = j*h with |t| <= tmax; the weights beyond tmax are below eps^2
+	numeric sum = halfpi * f((a + b) / 2);
+	numeric sumabs = abs(sum);
+	numeric tmax = 1;
+	while (halfpi * cosh(tmax) / cosh(halfpi * sinh(tmax)).power(2) > eps * eps)
+		tmax += numeric(1, 2);
+
+	numeric h = 1;
+	numeric previous;
+	for (int level = 0; level <= max_level; ++level) {
+		const long step = level == 0 ? 1 : 2;
+		for (long j = 1; ; j += step) {
+			const numeric t = j * h;
+			if (t > tmax)
+				break;
+			const numeric u = halfpi * sinh(t);
+			const numeric w = halfpi * cosh(t) / cosh(u).power(2);
+			// 1 - tanh(u), computed without cancellation
+			const numeric delta = 2 / (exp(2 * u) + 1);
+			// samples rounding to a singular end point are left out
+			const numeric xb = b - d * delta;
+			const numeric xa = a + d * delta;
+			numeric fs;
+			if (!xb.is_equal(b))
+				fs += f(xb);
+			if (!xa.is_equal(a))
+				fs += f(xa);
+			sum += w * fs;
+			sumabs += w * abs(fs);
+		}
+		const numeric approx = d * h * sum;
+		if (level > 1) {
+			const numeric tolerance = error * abs(approx) + eps * abs(d) * h * sumabs;
+			if (abs(approx - previous) <= tolerance) {
+				result = approx;
+				return true;
+			}
+		}
+		previous = approx;
+		h /= 2;
+	}
+	return false;
+}
+
+/** Tanh-sinh quadrature with bisection of the interval where the rule
+ *  does not converge. */
+static numeric adaptive_tanh_sinh(const numeric_integrand & f, const numeric & a, const numeric & b,
+                                  const numeric & error, int level)
+{
+	numeric result;
+	if (tanh_sinh(f, a, b, error, result))
+		return result;
+	if (level >= integral::max_integration_level)
+		throw runtime_error("max integration level reached");
+	const numeric m = (a + b) / 2;
+	return adaptive_tanh_sinh(f, a, m, error, level + 1) +
+	       adaptive_tanh_sinh(f, m, b, error, level + 1);
+}
+
+/** Numeric integration by tanh-sinh quadrature.  Parameters are as for
+ *  adaptivesimpson().  The integrand is lowered to a numeric evaluator
+ *  once, and the quadrature converges much faster than Simpson's rule for
+ *  analytic integrands and integrands with end point singularities.  The
+ *  result has the current precision Digits. */
+ex doubleexponential(const ex & x, const ex & a_in, const ex & b_in, const ex & f, const ex & error)
+{
+	// Check whether boundaries and error are numbers.
+	ex a = is_exactly_a<numeric>(a_in) ? a_in : a_in.evalf();
+	ex b = is_exactly_a<numeric>(b_in) ? b_in : b_in.evalf();
+	if(!is_exactly_a<numeric>(a) || !is_exactly_a<numeric>(b))
+		throw std::runtime_error("For numerical integration the boundaries of the integral should evalf into numbers.");
+	if(!is_exactly_a<numeric>(error))
+		throw std::runtime_error("For numerical integration the error should be a number.");
+
+	// Use lookup table to be potentially much faster.
+	static lookup_map lookup;
+	static symbol ivar("ivar");
+	ex lookupex = integral(ivar,a,b,f.subs(x==ivar));
+	auto emi = lookup.find(error_and_integral(error, lookupex));
+	if (emi!=lookup.end())
+		return emi->second;
+
+	numeric_integrand integrand(exvector(1, x), f);
+	ex result = adaptive_tanh_sinh(integrand, ex_to<numeric>(a.evalf()), ex_to<numeric>(b.evalf()),
+	                               ex_to<numeric>(error), 0);
+
+	lookup[error_and_integral(error, lookupex)]=result;
+	return result;
+}
+
+/** Nested integrals integral(x1, a1, b1, integral(x2, a2, b2, ...)), where
+ *  the boundaries may depend on the outer variables, transformed to an
+ *  integral of one lowered integrand over the unit hypercube. */
+class nested_integrand {
+public:
+	nested_integrand(const exvector & vars, const exvector & lower, const exvector & upper, const ex & f)
+	{
+		for (size_t i = 0; i < vars.size(); ++i) {
+			lo.emplace_back(vars, lower[i]);
+			hi.emplace_back(vars, upper[i]);
+		}
+		integrand.reset(new numeric_integrand(vars, f));
+	}
+
+	size_t dim() const { return lo.size(); }
+
+	numeric operator()(const std::vector<numeric> & u) const
+	{
+		std::vector<numeric> x(u.size());
+		numeric jacobian = *_num1_p;
+		for (size_t i = 0; i < u.size(); ++i) {
+			const numeric a = lo[i](x);
+			const numeric width = hi[i](x) - a;
+			x[i] = a + width * u[i];
+			jacobian *= width;
+		}
+		return jacobian * (*integrand)(x);
+	}
+
+private:
+	std::vector<numeric_integrand> lo, hi;
+	std::unique_ptr<numeric_integrand> integrand;
+};
+
+/** A subregion of the unit hypercube with its Genz-Malik estimates. */
+struct cubature_region {
+	std::vector<numeric> center, halfwidth;
+	numeric integral, error;
+	size_t split;    ///< axis along which the integrand varies most
+};
+
+struct cubature_region_is_less {
+	bool operator()(const cubature_region & r1, const cubature_region & r2) const
+	{
+		return r1.error < r2.error;
+	}
+};
+
+/** Applies the Genz-Malik rule of degree 7 with the embedded rule of
+ *  degree 5 (A.C. Genz and A.A. Malik, J. Comput. Appl. Math. 6 (1980)
+ *  295-302) to a region.  The difference of both rules is the error
+ *  estimate, and fourth differences along the axes choose the axis for
+ *  the next subdivision. */
+static void genz_malik(const nested_integrand & f, cubature_region & r)
+{
+	const size_t n = r.center.size();
+	const numeric lambda2 = sqrt(numeric(9, 70));
+	const numeric lambda4 = sqrt(numeric(9, 10));
+	const numeric lambda5 = sqrt(numeric(9, 19));
+	const numeric ratio = numeric(10, 70);    // (lambda2/lambda4)^2
+	const numeric nn = n;
+
+	numeric volume = *_num1_p;
+	for (auto & h : r.halfwidth)
+		volume *= 2 * h;
+
+	std::vector<numeric> p = r.center;
+	const numeric f0 = f(p);
+	numeric sum2, sum4, sum5, sum_corners;
+	numeric maxdiff = -1;
+	r.split = 0;
+	for (size_t i = 0; i < n; ++i) {
+		p[i] = r.center[i] - lambda2 * r.halfwidth[i];
+		const numeric f2m = f(p);
+		p[i] = r.center[i] + lambda2 * r.halfwidth[i];
+		const numeric f2p = f(p);
+		p[i] = r.center[i] - lambda4 * r.halfwidth[i];
+		const numeric f4m = f(p);
+		p[i] = r.center[i] + lambda4 * r.halfwidth[i];
+		const numeric f4p = f(p);
+		p[i] = r.center[i];
+		sum2 += f2m + f2p;
+		sum4 += f4m + f4p;
+		const numeric diff = abs(f2m + f2p - 2 * f0 - ratio * (f4m + f4p - 2 * f0));
+		if (diff > maxdiff) {
+			maxdiff = diff;
+			r.split = i;
+		}
+	}
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = i + 1; j < n; ++j) {
+			for (int s = 0; s < 4; ++s) {
+				p[i] = r.center[i] + (s & 1 ? -lambda4 : lambda4) * r.halfwidth[i];
+				p[j] = r.center[j] + (s & 2 ? -lambda4 : lambda4) * r.halfwidth[j];
+				sum5 += f(p);
+			}
+			p[j] = r.center[j];
+		}
+		p[i] = r.center[i];
+	}
+	for (unsigned long s = 0; s < (1ul << n); ++s) {
+		for (size_t i = 0; i < n; ++i)
+			p[i] = r.center[i] + ((s >> i) & 1 ? -lambda5 : lambda5) * r.halfwidth[i];
+		sum_corners += f(p);
+	}
+
+	const numeric rule7 = volume * (numeric(12824 - 9120 * nn + 400 * nn * nn) / 19683 * f0
+	                                + numeric(6859, 19683) / numeric(2).power(nn) * sum_corners
+	                                + numeric(980, 6561) * sum2
+	                                + (1820 - 400 * nn) / 19683 * sum4
+	                                + numeric(200, 19683) * sum5);
+	const numeric rule5 = volume * ((729 - 950 * nn + 50 * nn * nn) / 729 * f0
+	                                + numeric(245, 486) * sum2
+	                                + (265 - 100 * nn) / 1458 * sum4
+	                                + numeric(25, 729) * sum5);
+	r.integral = rule7;
+	r.error = abs(rule7 - rule5);
+}
+
+/** Globally adaptive cubature over the unit hypercube: the region with the
+ *  largest error is bisected along its most varying axis until the sum of
+ *  the errors is small enough. */
+static numeric adaptive_genz_malik(const nested_integrand & f, const numeric & error)
+{
+	const size_t n = f.dim();
+	const numeric eps = numeric(10).power(-long(Digits));
+	const size_t max_regions = size_t(1) << integral::max_integration_level;
+
+	std::priority_queue<cubature_region, std::vector<cubature_region>, cubature_region_is_less> regions;
+	cubature_region whole;
+	whole.center.assign(n, numeric(1, 2));
+	whole.halfwidth.assign(n, numeric(1, 2));
+	genz_malik(f, whole);
+	numeric total = whole.integral;
+	numeric total_error = whole.error;
+	regions.push(std::move(whole));
+
+	while (total_error > error * abs(total) && total_error > eps * abs(total)) {
+		if (regions.size() >= max_regions)
+			throw runtime_error("max integration level reached");
+		cubature_region r = regions.top();
+		regions.pop();
+		total -= r.integral;
+		total_error -= r.error;
+
+		const size_t k = r.split;
+		cubature_region r2 = r;
+		r.halfwidth[k] /= 2;
+		r2.halfwidth[k] = r.halfwidth[k];
+		r.center[k] -= r.halfwidth[k];
+		r2.center[k] += r2.halfwidth[k];
+		genz_malik(f, r);
+		genz_malik(f, r2);
+		total += r.integral + r2.integral;
+		total_error += r.error + r2.error;
+		regions.push(std::move(r));
+		regions.push(std::move(r2));
+	}
+	return total;
+}
+
+/** Quasi-Monte Carlo cubature over the unit hypercube with randomly
+ *  shifted rank-1 lattice rules of Korobov type, for dimensions where the
+ *  number of points of the Genz-Malik rule grows too fast.  The integrand
+ *  is periodized with the tent transform, and the spread of the estimates
+ *  of the different shifts gives the error estimate. */
+static numeric lattice_cubature(const nested_integrand & f, const numeric & error)
+{
+	static const long primes[] = { 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071 };
+	static const int shifts = 8;
+	const double pi = 3.14159265358979323846;
+	const size_t n = f.dim();
+	std::mt19937 rng(4711);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	// the products of lattice indices below N reach N^2, which needs 64 bits
+	for (long long N : primes) {
+		// Korobov generator (1, a, a^2, ...) mod N, chosen among a few
+		// candidates by the worst-case error for periodic functions
+		long long best_a = 1;
+		double best_p = 0;
+		const long long candidates = 32;
+		for (long long c = 1; c <= candidates; ++c) {
+			const long long a = 2 + c * (N / 2 - 2) / candidates;
+			double p = 0;
+			for (long long k = 0; k < N; ++k) {
+				double prod = 1;
+				long long z = 1;
+				for (size_t i = 0; i < n; ++i) {
+					double x = double((k * z) % N) / N;
+					prod *= 1 + 2 * pi * pi * (x * x - x + 1.0 / 6);
+					z = (z * a) % N;
+				}
+				p += prod;
+			}
+			if (best_a == 1 || p < best_p) {
+				best_a = a;
+				best_p = p;
+			}
+		}
+
+		std::vector<numeric> estimates;
+		std::vector<numeric> u(n);
+		for (int s = 0; s < shifts; ++s) {
+			std::vector<double> shift(n);
+			for (auto & d : shift)
+				d = uniform(rng);
+			numeric sum;
+			for (long long k = 0; k < N; ++k) {
+				long long z = 1;
+				for (size_t i = 0; i < n; ++i) {
+					double x = double((k * z) % N) / N + shift[i];
+					x -= std::floor(x);
+					u[i] = numeric(1 - std::fabs(2 * x - 1));
+					z = (z * best_a) % N;
+				}
+				sum += f(u);
+			}
+			estimates.push_back(sum / N);
+		}
+
+		numeric mean;
+		for (auto & q : estimates)
+			mean += q;
+		mean = mean / shifts;
+		numeric variance;
+		for (auto & q : estimates)
+			variance += (q - mean) * (q - mean);
+		variance = variance / (shifts * (shifts - 1));
+		if (3 * sqrt(variance) <= error * abs(mean))
+			return mean;
+	}
+	throw runtime_error("max integration level reached");
+}
+
+/** Numeric evaluation of nested integrals
+ *  integral(x1, a1, b1, integral(x2, a2, b2, ... f)) in one cubature over
+ *  all variables, instead of one quadrature per sample of the outer
+ *  integrals.  The boundaries of the inner integrals may depend on the
+ *  outer variables.  Up to seven dimensions the adaptive Genz-Malik rule
+ *  is used, above that a randomized lattice rule.  The integrand and the
+ *  boundaries must evalf into numbers once numbers are substituted for all
+ *  integration variables. */
+ex adaptivecubature(const ex & e, const ex & error)
+{
+	if(!is_exactly_a<numeric>(error))
+		throw std::runtime_error("For numerical integration the error should be a number.");
+
+	exvector vars, lower, upper;
+	ex f = e;
+	while (is_exactly_a<integral>(f)) {
+		vars.push_back(f.op(0));
+		lower.push_back(f.op(1).evalf());
+		upper.push_back(f.op(2).evalf());
+		f = f.op(3);
+	}
+	if (vars.empty())
+		return e.evalf();
+	if (!is_exactly_a<numeric>(lower[0]) || !is_exactly_a<numeric>(upper[0]))
+		throw std::runtime_error("For numerical integration the boundaries of the integral should evalf into numbers.");
+	if (vars.size() == 1)
+		return doubleexponential(vars[0], lower[0], upper[0], f, error);
+
+	nested_integrand integrand(vars, lower, upper, f.evalf());
+	if (vars.size() <= 7)
+		return adaptive_genz_malik(integrand, ex_to<numeric>(error));
+	return lattice_cubature(integrand, ex_to<numeric>(error));
+}
+
 int integral::degree(const ex & s) const
 {
 	return ((b-a)*f).degree(s);
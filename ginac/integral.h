@@ -91,6 +91,19 @@ GiNaC::ex adaptivesimpson(
 	const GiNaC::ex &error = integral::relative_integration_error
 );
 
+GiNaC::ex doubleexponential(
+	const GiNaC::ex &x,
+	const GiNaC::ex &a,
+	const GiNaC::ex &b,
+	const GiNaC::ex &f,
+	const GiNaC::ex &error = integral::relative_integration_error
+);
+
+GiNaC::ex adaptivecubature(
+	const GiNaC::ex &e,
+	const GiNaC::ex &error = integral::relative_integration_error
+);
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_INTEGRAL_H
@@ -34,8 +34,11 @@
 #include "utils.h"
 #include "inifcns.h"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <stdexcept>
+#include <vector>
 #include <cln/cln.h>
 
 
@@ -93,6 +96,155 @@ numeric kronecker_symbol_prime(const numeric & a, const numeric & n)
 	return GiNaC::smod( pow(a,(n-1)/2), n);
 }
 
+/**
+ *
+ * Returns the table of smallest prime factors of the integers 0,...,n-1 (0 and 1 map to themselves),
+ * computed by a sieve of Eratosthenes.
+ *
+ * The table is cached and only grows.
+ *
+ */
+const std::vector<long> & smallest_prime_factors(long n)
+{
+	static std::vector<long> spf;
+
+	if ( long(spf.size()) < n ) {
+		long size = std::max(n, 2*long(spf.size()));
+		spf.assign(size, 0);
+		for (long i1=0; i1<size; i1++) {
+			spf[i1] = i1;
+		}
+		for (long p=2; p*p<size; p++) {
+			if ( spf[p] == p ) {
+				for (long m=p*p; m<size; m+=p) {
+					if ( spf[m] == m ) {
+						spf[m] = p;
+					}
+				}
+			}
+		}
+	}
+
+	return spf;
+}
+
+/**
+ *
+ * Returns the values of the primitive Dirichlet character defined by the discriminant a
+ * at 0,...,n-1.
+ *
+ * The Kronecker symbol (a/m) is completely multiplicative in m, hence the table follows from
+ * its values at the primes and the sieve of smallest prime factors.
+ * The Legendre symbols at odd primes are computed by modular exponentiation.
+ *
+ * The tables are cached per a.
+ *
+ */
+const std::vector<int> & character_table(long a, long n)
+{
+	static std::map<long, std::vector<int>> cache;
+
+	std::vector<int> & chi = cache[a];
+	if ( long(chi.size()) < n ) {
+		long size = std::max(n, 2*long(chi.size()));
+		const std::vector<long> & spf = smallest_prime_factors(size);
+		chi.assign(size, 0);
+		if ( size > 1 ) {
+			chi[1] = 1;
+		}
+		for (long m=2; m<size; m++) {
+			long p = spf[m];
+			int chi_p;
+			if ( p == 2 ) {
+				chi_p = kronecker_symbol_prime(a,2).to_int();
+			}
+			else {
+				// Euler's criterion: a^((p-1)/2) mod p
+				long base = ((a % p) + p) % p;
+				long e = (p-1)/2;
+				long r = 1;
+				while ( e > 0 ) {
+					if ( e & 1 ) {
+						r = (r*base) % p;
+					}
+					base = (base*base) % p;
+					e >>= 1;
+				}
+				chi_p = (r == 0) ? 0 : ((r == 1) ? 1 : -1);
+			}
+			chi[m] = chi_p * chi[m/p];
+		}
+	}
+
+	return chi;
+}
+
+/**
+ *
+ * Returns the divisors of the positive integer n, using the sieve of smallest prime factors.
+ *
+ */
+std::vector<long> divisors(long n)
+{
+	const std::vector<long> & spf = smallest_prime_factors(n+1);
+
+	std::vector<long> res(1, 1);
+	while ( n > 1 ) {
+		long p = spf[n];
+		int e = 0;
+		while ( n % p == 0 ) {
+			n /= p;
+			e++;
+		}
+		size_t n_old = res.size();
+		long pe = 1;
+		for (int i1=1; i1<=e; i1++) {
+			pe *= p;
+			for (size_t i2=0; i2<n_old; i2++) {
+				res.push_back(res[i2]*pe);
+			}
+		}
+	}
+
+	return res;
+}
+
+/**
+ *
+ * Returns the values of divisor_function(n,a,b,k) for n=0,...,n_max-1 (the entry for n=0 is zero).
+ *
+ * The sums over divisors are accumulated by running over all pairs (d,m) with d*m<n_max,
+ * which costs O(n_max log n_max) operations for the whole table.
+ *
+ * The tables are cached per (k,a,b).
+ *
+ */
+const std::vector<numeric> & divisor_function_table(const numeric & k, const numeric & a, const numeric & b, long n_max)
+{
+	static std::map<std::vector<long>, std::vector<numeric>> cache;
+
+	std::vector<numeric> & res = cache[{k.to_long(), a.to_long(), b.to_long()}];
+	if ( long(res.size()) < n_max ) {
+		long size = std::max(n_max, 2*long(res.size()));
+		const std::vector<int> & phi = character_table(a.to_long(), size);
+		const std::vector<int> & psi = character_table(b.to_long(), size);
+		res.assign(size, 0);
+		for (long d=1; d<size; d++) {
+			if ( psi[d] == 0 ) {
+				continue;
+			}
+			numeric term = psi[d] * numeric(d).power(k-1);
+			for (long m=1; d*m<size; m++) {
+				if ( phi[m] != 0 ) {
+					res[d*m] += phi[m] * term;
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
 /**
  *
  * n:     positive integer
@@ -116,16 +268,7 @@ numeric kronecker_symbol_prime(const numeric & a, const numeric & n)
  */
 numeric divisor_function(const numeric & n, const numeric & a, const numeric & b, const numeric & k)
 {
-	ex res = 0;
-
-	for (numeric i1=1; i1<=n; i1++) {
-		if ( irem(n,i1) == 0 ) {
-			numeric ratio = n/i1;
-			res += primitive_dirichlet_character(ratio,a) * primitive_dirichlet_character(i1,b) * pow(i1,k-1);
-		}
-	}
-
-	return ex_to<numeric>(res);
+	return divisor_function_table(k,a,b,n.to_long()+1)[n.to_long()];
 }
 
 /**
@@ -180,13 +323,19 @@ numeric coefficient_a0(const numeric & k, const numeric & a, const numeric & b)
  */
 ex eisenstein_series(const numeric & k, const ex & q, const numeric & a, const numeric & b, const numeric & N)
 {
-	ex res = coefficient_a0(k,a,b);
+	long N_long = N.to_long();
+	const std::vector<numeric> & coeff = divisor_function_table(k,a,b,N_long);
 
-	for (numeric i1=1; i1<N; i1++) {
-		res += divisor_function(i1,a,b,k) * pow(q,i1);
+	exvector terms;
+	terms.reserve(N_long);
+	terms.push_back(coefficient_a0(k,a,b));
+	for (long i1=1; i1<N_long; i1++) {
+		if ( !coeff[i1].is_zero() ) {
+			terms.push_back(coeff[i1] * pow(q,i1));
+		}
 	}
 
-	return res;
+	return dynallocate<add>(terms);
 }
 
 /**
@@ -743,6 +892,9 @@ ex  integration_kernel::get_numerical_value_impl(const ex & lambda, const ex & p
 	cln::cl_N resbuf;
 	cln::cl_N subexpr;
 
+	// lambda^(N-1+shift), updated by one multiplication per term
+	cln::cl_N lambda_power = cln::expt(lambda_cln,shift-1);
+
 	if ( N_trunc == 0 ) {
 		// sum until precision is reached
 		bool flag_accidental_zero = false;
@@ -754,7 +906,8 @@ ex  integration_kernel::get_numerical_value_impl(const ex & lambda, const ex & p
 	 
 			subexpr = series_coeff(N);
 
-			res += pre_cln * subexpr * cln::expt(lambda_cln,N-1+shift);
+			res += pre_cln * subexpr * lambda_power;
+			lambda_power = lambda_power * lambda_cln;
 
 			flag_accidental_zero = cln::zerop(subexpr);
 
@@ -766,7 +919,8 @@ ex  integration_kernel::get_numerical_value_impl(const ex & lambda, const ex & p
 		for (int N=0; N<N_trunc; N++) {
 			subexpr = series_coeff(N);
 
-			res += pre_cln * subexpr * cln::expt(lambda_cln,N-1+shift);
+			res += pre_cln * subexpr * lambda_power;
+			lambda_power = lambda_power * lambda_cln;
 		}
 	}
 
@@ -1864,34 +2018,42 @@ ex Eisenstein_h_kernel::coefficient_a0(const numeric & k, const numeric & r, con
  */
 ex Eisenstein_h_kernel::coefficient_an(const numeric & n, const numeric & k, const numeric & r, const numeric & s, const numeric & N) const
 {
-	ex res = 0;
+	exvector terms;
 
-	for (numeric m=1; m<=n; m++) {
-		if ( irem(n,m) == 0 ) {
-			for (numeric c1=0; c1<N; c1++) {
-				numeric c2 = n/m;
-				res += pow(m,k-1)*exp(2*Pi*I/N*mod(r*c2-(s-m)*c1,N)) - pow(-m,k-1)*exp(2*Pi*I/N*mod(-r*c2+(s+m)*c1,N));
-			}
+	for (long m_long : divisors(n.to_long())) {
+		numeric m = m_long;
+		numeric c2 = n/m;
+		for (numeric c1=0; c1<N; c1++) {
+			terms.push_back(pow(m,k-1)*exp(2*Pi*I/N*mod(r*c2-(s-m)*c1,N)) - pow(-m,k-1)*exp(2*Pi*I/N*mod(-r*c2+(s+m)*c1,N)));
 		}
 	}
 
-	return res/numeric(2)/pow(N,k);
+	return dynallocate<add>(terms)/numeric(2)/pow(N,k);
 }
 
 ex Eisenstein_h_kernel::q_expansion_modular_form(const ex & q, int N_order) const
 {
-	numeric N_order_num = numeric(N_order);
-
 	numeric k_num = ex_to<numeric>(k);
 	numeric r_num = ex_to<numeric>(r);
 	numeric s_num = ex_to<numeric>(s);
 	numeric N_num = ex_to<numeric>(N);
 
-	ex res = coefficient_a0(k_num,r_num,s_num,N_num);
+	// the coefficients only depend on (k,r,s,N), cache them
+	static std::map<std::vector<long>, exvector> cache;
+	exvector & coeff = cache[{k_num.to_long(), r_num.to_long(), s_num.to_long(), N_num.to_long()}];
+	if ( coeff.empty() ) {
+		coeff.push_back(coefficient_a0(k_num,r_num,s_num,N_num));
+	}
+	for (long i1=coeff.size(); i1<N_order; i1++) {
+		coeff.push_back(coefficient_an(i1,k_num,r_num,s_num,N_num));
+	}
 
-	for (numeric i1=1; i1<N_order_num; i1++) {
-		res += coefficient_an(i1,k_num,r_num,s_num,N_num) * pow(q,i1);
+	exvector terms;
+	terms.reserve(N_order);
+	for (long i1=0; i1<N_order; i1++) {
+		terms.push_back(coeff[i1] * pow(q,i1));
 	}
+	ex res = dynallocate<add>(terms);
 
 	res += Order(pow(q,N_order));
 	res = res.series(q,N_order);
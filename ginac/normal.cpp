@@ -39,9 +39,15 @@
 #include "operators.h"
 #include "matrix.h"
 #include "pseries.h"
+#include "ratfunc.h"
 #include "symbol.h"
 #include "utils.h"
 #include "polynomial/chinrem_gcd.h"
+#include "polynomial/gcd_uvar.h"
+#include "polynomial/pgcd.h"
+#include "polynomial/multipoint.h"
+#include "polynomial/ratinterp.h"
+#include "polynomial/mod_bezout.h"
 
 #include <algorithm>
 #include <map>
@@ -159,18 +165,43 @@ struct sym_desc {
 // Vector of sym_desc structures
 typedef std::vector<sym_desc> sym_desc_vec;
 
-// Add symbol the sym_desc_vec (used internally by get_symbol_stats())
-static void add_symbol(const ex &s, sym_desc_vec &v)
+/** Statistical information about a single polynomial, gathered in one
+ *  traversal by get_poly_stats() and reused by the GCD routines.
+ *
+ *  @see get_poly_stats */
+struct poly_stats {
+	poly_stats() : denom_lcm(*_num1_p) { }
+
+	/** Symbols of the polynomial, in order of first appearance */
+	exvector syms;
+
+	/** Highest degree of each symbol */
+	std::vector<int> deg;
+
+	/** Lowest degree of each symbol */
+	std::vector<int> ldeg;
+
+	/** Number of terms of the leading coefficient in each symbol */
+	std::vector<size_t> lcnops;
+
+	/** LCM of the denominators of the coefficients (as computed by
+	 *  lcm_of_coefficients_denominators()) */
+	numeric denom_lcm;
+};
+
+// Add symbol to a vector of symbols unless it's already in there
+// (used internally by collect_symbols())
+static void add_symbol(const ex &s, exvector &v)
 {
 	for (auto & it : v)
-		if (it.sym.is_equal(s))  // If it's already in there, don't add it a second time
+		if (it.is_equal(s))  // If it's already in there, don't add it a second time
 			return;
 
-	v.push_back(sym_desc(s));
+	v.push_back(s);
 }
 
-// Collect all symbols of an expression (used internally by get_symbol_stats())
-static void collect_symbols(const ex &e, sym_desc_vec &v)
+// Collect all symbols of an expression (used internally by get_poly_stats())
+static void collect_symbols(const ex &e, exvector &v)
 {
 	if (is_a<symbol>(e)) {
 		add_symbol(e, v);
@@ -182,6 +213,127 @@ static void collect_symbols(const ex &e, sym_desc_vec &v)
 	}
 }
 
+// Compute the highest and lowest degrees of all symbols in syms together
+// with the LCM of the denominators of the coefficients in one traversal of
+// the expression (used internally by get_poly_stats()). The degrees follow
+// ex::degree() and ex::ldegree(), the LCM follows lcmcoeff(). If lcnops is
+// not null and e is a sum, the number of terms of the leading coefficients
+// is stored there.
+static numeric poly_stats_walk(const ex &e, const numeric &l, const exvector &syms,
+                               std::vector<int> &deg, std::vector<int> &ldeg,
+                               std::vector<size_t> *lcnops = nullptr)
+{
+	if (e.info(info_flags::rational))
+		return lcm(ex_to<numeric>(e).denom(), l);
+
+	if (is_a<symbol>(e)) {
+		for (size_t i=0; i<syms.size(); i++) {
+			if (syms[i].is_equal(e)) {
+				deg[i] = ldeg[i] = 1;
+				break;
+			}
+		}
+		return l;
+	}
+
+	const size_t nsyms = syms.size();
+	if (is_exactly_a<add>(e)) {
+		numeric c = *_num1_p;
+		std::vector<int> tdeg(nsyms), tldeg(nsyms);
+		std::vector<size_t> top(nsyms);
+		for (size_t i=0; i<e.nops(); i++) {
+			std::fill(tdeg.begin(), tdeg.end(), 0);
+			std::fill(tldeg.begin(), tldeg.end(), 0);
+			c = poly_stats_walk(e.op(i), c, syms, tdeg, tldeg);
+			for (size_t j=0; j<nsyms; j++) {
+				if (i == 0 || tdeg[j] > deg[j]) {
+					deg[j] = tdeg[j];
+					top[j] = 1;
+				} else if (tdeg[j] == deg[j]) {
+					++top[j];
+				}
+				if (i == 0 || tldeg[j] < ldeg[j])
+					ldeg[j] = tldeg[j];
+			}
+		}
+		if (lcnops)
+			*lcnops = top;
+		return lcm(c, l);
+	}
+
+	if (is_exactly_a<mul>(e)) {
+		numeric c = *_num1_p;
+		std::vector<int> fdeg(nsyms), fldeg(nsyms);
+		for (size_t i=0; i<e.nops(); i++) {
+			std::fill(fdeg.begin(), fdeg.end(), 0);
+			std::fill(fldeg.begin(), fldeg.end(), 0);
+			c *= poly_stats_walk(e.op(i), *_num1_p, syms, fdeg, fldeg);
+			for (size_t j=0; j<nsyms; j++) {
+				deg[j] += fdeg[j];
+				ldeg[j] += fldeg[j];
+			}
+		}
+		return lcm(c, l);
+	}
+
+	if (is_exactly_a<power>(e) && is_exactly_a<numeric>(e.op(1))) {
+		const numeric &n = ex_to<numeric>(e.op(1));
+		numeric bl = poly_stats_walk(e.op(0), l, syms, deg, ldeg);
+		if (n.is_integer()) {
+			const int k = n.to_int();
+			for (size_t j=0; j<nsyms; j++) {
+				deg[j] *= k;
+				ldeg[j] *= k;
+			}
+		} else {
+			std::fill(deg.begin(), deg.end(), 0);
+			std::fill(ldeg.begin(), ldeg.end(), 0);
+		}
+		if (is_a<symbol>(e.op(0)))
+			return l;
+		return pow(bl, n);
+	}
+
+	return l;
+}
+
+/** Gather statistical information about a polynomial in a single
+ *  traversal: the degrees and low degrees in all of its symbols, the
+ *  number of terms of the leading coefficients and the LCM of the
+ *  denominators of its coefficients. The results for the most recently
+ *  seen polynomials are cached, since the GCD routines ask for the same
+ *  polynomials over and over again.
+ *
+ *  @param e  multivariate polynomial (need not be expanded)
+ *  @see get_symbol_stats */
+static poly_stats get_poly_stats(const ex &e)
+{
+	struct cache_entry {
+		cache_entry() : used(false) { }
+		ex key;
+		poly_stats stats;
+		bool used;
+	};
+	static const size_t cache_size = 256;
+	static std::vector<cache_entry> cache(cache_size);
+
+	cache_entry &slot = cache[e.gethash() % cache_size];
+	if (slot.used && slot.key.is_equal(e))
+		return slot.stats;
+
+	poly_stats st;
+	collect_symbols(e, st.syms);
+	st.deg.resize(st.syms.size());
+	st.ldeg.resize(st.syms.size());
+	st.lcnops.assign(st.syms.size(), 1);
+	st.denom_lcm = poly_stats_walk(e, *_num1_p, st.syms, st.deg, st.ldeg, &st.lcnops);
+
+	slot.key = e;
+	slot.stats = st;
+	slot.used = true;
+	return st;
+}
+
 /** Collect statistical information about symbols in polynomials.
  *  This function fills in a vector of "sym_desc" structs which contain
  *  information about the highest and lowest degrees of all symbols that
@@ -196,18 +348,30 @@ static void collect_symbols(const ex &e, sym_desc_vec &v)
  *  @param v  vector of sym_desc structs (filled in) */
 static void get_symbol_stats(const ex &a, const ex &b, sym_desc_vec &v)
 {
-	collect_symbols(a, v);
-	collect_symbols(b, v);
-	for (auto & it : v) {
-		int deg_a = a.degree(it.sym);
-		int deg_b = b.degree(it.sym);
-		it.deg_a = deg_a;
-		it.deg_b = deg_b;
-		it.max_deg = std::max(deg_a, deg_b);
-		it.max_lcnops = std::max(a.lcoeff(it.sym).nops(), b.lcoeff(it.sym).nops());
-		it.ldeg_a = a.ldegree(it.sym);
-		it.ldeg_b = b.ldegree(it.sym);
+	const poly_stats sa = get_poly_stats(a);
+	const poly_stats sb = get_poly_stats(b);
+
+	for (size_t i=0; i<sa.syms.size(); i++) {
+		v.push_back(sym_desc(sa.syms[i]));
+		sym_desc &d = v.back();
+		d.deg_a = sa.deg[i];
+		d.ldeg_a = sa.ldeg[i];
+		d.max_lcnops = sa.lcnops[i];
+	}
+	for (size_t i=0; i<sb.syms.size(); i++) {
+		auto it = v.begin();
+		while (it != v.end() && !it->sym.is_equal(sb.syms[i]))
+			++it;
+		if (it == v.end()) {
+			v.push_back(sym_desc(sb.syms[i]));
+			it = v.end() - 1;
+		}
+		it->deg_b = sb.deg[i];
+		it->ldeg_b = sb.ldeg[i];
+		it->max_lcnops = std::max(it->max_lcnops, sb.lcnops[i]);
 	}
+	for (auto & it : v)
+		it.max_deg = std::max(it.deg_a, it.deg_b);
 	std::sort(v.begin(), v.end());
 
 #if 0
@@ -260,7 +424,7 @@ static numeric lcmcoeff(const ex &e, const numeric &l)
  *  @return LCM of denominators of coefficients */
 static numeric lcm_of_coefficients_denominators(const ex &e)
 {
-	return lcmcoeff(e, *_num1_p);
+	return get_poly_stats(e).denom_lcm;
 }
 
 /** Bring polynomial from Q[X] to Z[X] by multiplying in the previously
@@ -1304,8 +1468,28 @@ static bool heur_gcd_z(ex& res, const ex &a, const ex &b, ex *ca, ex *cb,
 	numeric rgc = gc.inverse();
 	ex p = a * rgc;
 	ex q = b * rgc;
+
+	// Univariate polynomials are evaluated and interpolated on dense
+	// coefficient vectors instead of expressions
+	upoly up, uq;
+	if (to_upoly(up, p, x) && to_upoly(uq, q, x)) {
+		upoly ug, uca, ucb;
+		if (!heur_gcd_z(ug, uca, ucb, up, uq))
+			return false;
+		res = from_upoly(ug, x) * gc;
+		if (ca)
+			*ca = from_upoly(uca, x);
+		if (cb)
+			*cb = from_upoly(ucb, x);
+		return true;
+	}
+
 	int maxdeg =  std::max(p.degree(x), q.degree(x));
-	
+
+	// Bound the degree of the GCD in x modulo a small prime, so that
+	// wrong candidates can be rejected without trial division
+	const int degree_bound = gcd_degree_bound(p, q, x);
+
 	// Find evaluation point
 	numeric mp = p.max_coefficient();
 	numeric mq = q.max_coefficient();
@@ -1338,7 +1522,8 @@ static bool heur_gcd_z(ex& res, const ex &a, const ex &b, ex *ca, ex *cb,
 
 			// If the calculated polynomial divides both p and q, this is the GCD
 			ex dummy;
-			if (divide_in_z(p, g, ca ? *ca : dummy, var) && divide_in_z(q, g, cb ? *cb : dummy, var)) {
+			if ((degree_bound < 0 || g.degree(x) <= degree_bound) &&
+			    divide_in_z(p, g, ca ? *ca : dummy, var) && divide_in_z(q, g, cb ? *cb : dummy, var)) {
 				g *= gc;
 				res = g;
 				return true;
@@ -1382,7 +1567,7 @@ static bool heur_gcd(ex& res, const ex& a, const ex& b, ex *ca, ex *cb,
 
 	// convert polynomials to Z[X]
 	const numeric a_lcm = lcm_of_coefficients_denominators(a);
-	const numeric ab_lcm = lcmcoeff(b, a_lcm);
+	const numeric ab_lcm = lcm(lcm_of_coefficients_denominators(b), a_lcm);
 
 	const ex ai = a*ab_lcm;
 	const ex bi = b*ab_lcm;
@@ -1410,6 +1595,40 @@ static bool heur_gcd(ex& res, const ex& a, const ex& b, ex *ca, ex *cb,
 }
 
 
+/** GCD algorithms gcd() can choose from. */
+enum gcd_algorithm {
+	heuristic_gcd,      ///< heur_gcd(), falling back to dense_modular_gcd
+	dense_modular_gcd,  ///< chinrem_gcd() with dense interpolation
+	sparse_modular_gcd  ///< chinrem_gcd() with Zippel's sparse interpolation
+};
+
+/** Choose the GCD algorithm from the shape of the expanded inputs. The
+ *  heuristic GCD evaluates at integers whose size grows with the degrees
+ *  in all variables, and dense interpolation needs as many images as the
+ *  degree bounds allow for. Both are wasteful for sparse polynomials in
+ *  three or more variables, which get the sparse modular algorithm.
+ *
+ *  @param a  first expanded polynomial
+ *  @param b  second expanded polynomial
+ *  @param v  symbol statistics of a and b (from get_symbol_stats())
+ *  @see gcd */
+static gcd_algorithm choose_gcd_algorithm(const ex &a, const ex &b, const sym_desc_vec &v)
+{
+	if (v.size() < 3)
+		return heuristic_gcd;
+
+	// Fraction of the monomials allowed by the degrees actually present
+	double dense_a = 1, dense_b = 1;
+	for (auto & it : v) {
+		dense_a *= it.deg_a + 1;
+		dense_b *= it.deg_b + 1;
+	}
+	const double terms_a = is_exactly_a<add>(a) ? a.nops() : 1;
+	const double terms_b = is_exactly_a<add>(b) ? b.nops() : 1;
+	const double density = std::max(terms_a/dense_a, terms_b/dense_b);
+	return density < 0.1 ? sparse_modular_gcd : heuristic_gcd;
+}
+
 // gcd helper to handle partially factored polynomials (to avoid expanding
 // large expressions). At least one of the arguments should be a power.
 static ex gcd_pf_pow(const ex& a, const ex& b, ex* ca, ex* cb);
@@ -1597,9 +1816,11 @@ ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned optio
 		return g;
 	}
 
-	// Try heuristic algorithm first, fall back to PRS if that failed
+	// Try heuristic algorithm first unless the polynomials are sparse,
+	// fall back to a modular algorithm if that failed
+	const gcd_algorithm algo = choose_gcd_algorithm(aex, bex, sym_stats);
 	ex g;
-	if (!(options & gcd_options::no_heur_gcd)) {
+	if (algo == heuristic_gcd && !(options & gcd_options::no_heur_gcd)) {
 		bool found = heur_gcd(g, aex, bex, ca, cb, var);
 		if (found) {
 			// heur_gcd have already computed cofactors...
@@ -1624,7 +1845,17 @@ ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned optio
 		exvector vars;
 		for (std::size_t n = sym_stats.size(); n-- != 0; )
 			vars.push_back(sym_stats[n].sym);
-		g = chinrem_gcd(aex, bex, vars);
+		bool found = false;
+		if (algo == sparse_modular_gcd) {
+			try {
+				g = chinrem_gcd(aex, bex, vars, true);
+				found = true;
+			} catch (pgcd_failed &) {
+			} catch (chinrem_gcd_failed &) {
+			}
+		}
+		if (!found)
+			g = chinrem_gcd(aex, bex, vars);
 	}
 
 	if (g.is_equal(_ex1)) {
@@ -1938,6 +2169,248 @@ ex sqrfree(const ex &a, const lst &l)
 }
 
 
+/*
+ *  Partial fraction decomposition
+ */
+
+/** Dense polynomial in x whose coefficients are rational functions of the
+ *  other symbols, each kept in normal form. */
+typedef std::vector<ex> kpoly;
+
+static void kpoly_canonicalize(kpoly & p)
+{
+	while (!p.empty() && p.back().is_zero())
+		p.pop_back();
+}
+
+static kpoly to_kpoly(const ex & e, const symbol & x)
+{
+	const ex en = e.expand();
+	kpoly p(en.degree(x) + 1);
+	for (size_t i = 0; i < p.size(); ++i)
+		p[i] = en.coeff(x, i).normal();
+	kpoly_canonicalize(p);
+	return p;
+}
+
+static ex from_kpoly(const kpoly & p, const symbol & x)
+{
+	exvector terms;
+	terms.reserve(p.size());
+	for (size_t i = 0; i < p.size(); ++i)
+		if (!p[i].is_zero())
+			terms.push_back(p[i] * pow(x, i));
+	return dynallocate<add>(terms);
+}
+
+static kpoly kpoly_mul(const kpoly & a, const kpoly & b)
+{
+	if (a.empty() || b.empty())
+		return kpoly();
+	std::vector<exvector> terms(a.size() + b.size() - 1);
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i].is_zero())
+			continue;
+		for (size_t j = 0; j < b.size(); ++j)
+			if (!b[j].is_zero())
+				terms[i + j].push_back(a[i] * b[j]);
+	}
+	kpoly c;
+	c.reserve(terms.size());
+	for (auto & t : terms)
+		c.push_back(ex(dynallocate<add>(t)).normal());
+	kpoly_canonicalize(c);
+	return c;
+}
+
+static kpoly kpoly_sub(const kpoly & a, const kpoly & b)
+{
+	kpoly c(a);
+	if (c.size() < b.size())
+		c.resize(b.size(), _ex0);
+	for (size_t i = 0; i < b.size(); ++i)
+		c[i] = (c[i] - b[i]).normal();
+	kpoly_canonicalize(c);
+	return c;
+}
+
+/** Quotient q and remainder r of a and b != 0. */
+static void kpoly_divide(kpoly & q, kpoly & r, const kpoly & a, const kpoly & b)
+{
+	GINAC_ASSERT(!b.empty());
+	r = a;
+	q.clear();
+	if (a.size() < b.size())
+		return;
+	const size_t n = b.size() - 1;
+	q.assign(a.size() - n, _ex0);
+	for (size_t k = a.size(); k-- > n; ) {
+		if (r[k].is_zero())
+			continue;
+		const ex qk = (r[k] / b[n]).normal();
+		q[k - n] = qk;
+		for (size_t i = 0; i < n; ++i)
+			r[k - n + i] = (r[k - n + i] - qk * b[i]).normal();
+		r[k] = _ex0;
+	}
+	r.resize(n);
+	kpoly_canonicalize(r);
+	kpoly_canonicalize(q);
+}
+
+/** Product of the polynomials p[lo], ..., p[hi-1], multiplied in a
+ *  balanced tree. */
+static kpoly kpoly_product(const std::vector<kpoly> & p, size_t lo, size_t hi)
+{
+	if (hi == lo)
+		return kpoly(1, _ex1);
+	if (hi - lo == 1)
+		return p[lo];
+	const size_t mid = lo + (hi - lo) / 2;
+	return kpoly_mul(kpoly_product(p, lo, mid), kpoly_product(p, mid, hi));
+}
+
+static bool kpoly_is_rational(const kpoly & p)
+{
+	for (auto & c : p)
+		if (!c.info(info_flags::rational))
+			return false;
+	return true;
+}
+
+/** The integer polynomial l*p for a polynomial p with rational
+ *  coefficients, l being the LCM of the denominators. */
+static upoly kpoly_to_upoly(const kpoly & p, numeric & l)
+{
+	l = *_num1_p;
+	for (auto & c : p)
+		l = lcm(l, ex_to<numeric>(c).denom());
+	upoly u;
+	u.reserve(p.size());
+	for (auto & c : p)
+		u.push_back(cln::the<cln::cl_I>((ex_to<numeric>(c) * l).to_cl_N()));
+	return u;
+}
+
+/** Cofactor s with s a = 1 (mod b) and deg(s) < deg(b), for coprime a and b
+ *  of positive degree.  Polynomials with rational coefficients are handled
+ *  modulo primes, which avoids the coefficient growth of the remainder
+ *  sequence over Q.
+ *
+ *  @exception invalid_argument (a and b are not coprime) */
+static kpoly kpoly_bezout(const kpoly & a, const kpoly & b)
+{
+	if (kpoly_is_rational(a) && kpoly_is_rational(b)) {
+		numeric la, lb;
+		std::vector<cln::cl_N> s;
+		if (!mod_bezout(s, kpoly_to_upoly(a, la), kpoly_to_upoly(b, lb)))
+			throw std::invalid_argument("parfrac: factors of the denominator are not coprime");
+		// s (la a) = 1 (mod b)
+		kpoly ks;
+		ks.reserve(s.size());
+		for (auto & c : s)
+			ks.push_back(numeric(c) * la);
+		return ks;
+	}
+
+	// extended Euclidean algorithm, with s_i a = r_i (mod b)
+	kpoly q, r0 = b, r1, s0, s1(1, _ex1);
+	kpoly_divide(q, r1, a, b);
+	while (r1.size() > 1) {
+		kpoly r2;
+		kpoly_divide(q, r2, r0, r1);
+		kpoly s2 = kpoly_sub(s0, kpoly_mul(q, s1));
+		r0.swap(r1);
+		r1.swap(r2);
+		s0.swap(s1);
+		s1.swap(s2);
+	}
+	if (r1.empty())
+		throw std::invalid_argument("parfrac: factors of the denominator are not coprime");
+	const ex inv = (_ex1 / r1[0]).normal();
+	for (auto & c : s1)
+		c = (c * inv).normal();
+	return s1;
+}
+
+/** Add the partial fractions of n/(d_lo ... d_{hi-1}) to terms, where
+ *  d_i = f[i].first^f[i].second is given expanded in d[i] and
+ *  deg(n) < deg(d_lo ... d_{hi-1}).
+ *
+ *  The factors are split in two halves D1 and D2.  With s D1 = 1 (mod D2),
+ *  n/(D1 D2) = n1/D1 + n2/D2 where n2 = n s mod D2 and n1 = (n - n2 D1)/D2,
+ *  so every level of the recursion takes a constant number of
+ *  multiplications and divisions instead of one dense linear system for
+ *  all numerators. */
+static void parfrac_split(exvector & terms, const kpoly & n,
+                          const std::vector<std::pair<ex, int>> & f,
+                          const std::vector<kpoly> & d,
+                          size_t lo, size_t hi, const symbol & x)
+{
+	if (n.empty())
+		return;
+
+	if (hi - lo == 1) {
+		// p-adic expansion n = r_k + p (r_{k-1} + p (...)) of the numerator
+		const kpoly p = to_kpoly(f[lo].first, x);
+		kpoly a = n;
+		for (int j = f[lo].second; j > 0 && !a.empty(); --j) {
+			kpoly q, r;
+			kpoly_divide(q, r, a, p);
+			if (!r.empty())
+				terms.push_back(from_kpoly(r, x) * pow(f[lo].first, -j));
+			a.swap(q);
+		}
+		return;
+	}
+
+	const size_t mid = lo + (hi - lo) / 2;
+	const kpoly d1 = kpoly_product(d, lo, mid);
+	const kpoly d2 = kpoly_product(d, mid, hi);
+	const kpoly s = kpoly_bezout(d1, d2);
+
+	kpoly q, n1, n2, r;
+	kpoly_divide(q, n2, kpoly_mul(n, s), d2);
+	kpoly_divide(n1, r, kpoly_sub(n, kpoly_mul(n2, d1)), d2);
+	GINAC_ASSERT(r.empty());
+
+	parfrac_split(terms, n1, f, d, lo, mid, x);
+	parfrac_split(terms, n2, f, d, mid, hi, x);
+}
+
+/** Partial fraction decomposition of numer/(c f_1^k_1 ... f_m^k_m) with
+ *  respect to x, for pairwise coprime factors f_i of positive degree in x
+ *  and c free of x. */
+static ex parfrac_over_factors(const ex & numer, const ex & c,
+                               const std::vector<std::pair<ex, int>> & f,
+                               const symbol & x)
+{
+	std::vector<kpoly> d;
+	d.reserve(f.size());
+	for (auto & it : f) {
+		const kpoly p = to_kpoly(it.first, x);
+		kpoly pk = p;
+		for (int k = 1; k < it.second; ++k)
+			pk = kpoly_mul(pk, p);
+		d.push_back(pk);
+	}
+
+	kpoly n = to_kpoly(numer, x);
+	const ex cinv = (_ex1 / c).normal();
+	for (auto & coeff : n)
+		coeff = (coeff * cinv).normal();
+
+	// Convert N(x)/D(x) -> Q(x) + R(x)/D(x), so degree(R) < degree(D)
+	kpoly q, r;
+	kpoly_divide(q, r, n, kpoly_product(d, 0, d.size()));
+
+	exvector terms;
+	terms.push_back(from_kpoly(q, x));
+	if (!f.empty())
+		parfrac_split(terms, r, f, d, 0, f.size(), x);
+	return dynallocate<add>(terms);
+}
+
 /** Compute square-free partial fraction decomposition of rational function
  *  a(x).
  *
@@ -1950,83 +2423,84 @@ ex sqrfree_parfrac(const ex & a, const symbol & x)
 	// Find numerator and denominator
 	ex nd = numer_denom(a);
 	ex numer = nd.op(0), denom = nd.op(1);
-//std::clog << "numer = " << numer << ", denom = " << denom << std::endl;
 
-	// Convert N(x)/D(x) -> Q(x) + R(x)/D(x), so degree(R) < degree(D)
-	ex red_poly = quo(numer, denom, x), red_numer = rem(numer, denom, x).expand();
-//std::clog << "red_poly = " << red_poly << ", red_numer = " << red_numer << std::endl;
-
-	// Factorize denominator and compute cofactors
+	// Factorize denominator, the factors of one multiplicity stay together
 	epvector yun = sqrfree_yun(denom, x);
-	exvector factor, cofac;
-	size_t dim = 0;
-	for (size_t i=0; i<yun.size(); i++) {
-		numeric i_exponent = ex_to<numeric>(yun[i].coeff);
-		for (size_t j=0; j<i_exponent; j++) {
-			factor.push_back(pow(yun[i].rest, j+1));
-			dim += degree(yun[i].rest, x);
-			ex prod = _ex1;
-			for (size_t k=0; k<yun.size(); k++) {
-				if (yun[k].coeff == i_exponent)
-					prod *= pow(yun[k].rest, i_exponent-1-j);
-				else
-					prod *= pow(yun[k].rest, yun[k].coeff);
-			}
-			cofac.push_back(prod.expand());
+	std::vector<std::pair<ex, int>> factors;
+	ex prod = _ex1;
+	for (auto & it : yun) {
+		if (it.rest.degree(x) > 0) {
+			factors.push_back(std::make_pair(it.rest, ex_to<numeric>(it.coeff).to_int()));
+			prod *= pow(it.rest, it.coeff);
 		}
 	}
-//std::clog << "factors  : " << exprseq(factor) << std::endl;
-//std::clog << "cofactors: " << exprseq(cofac) << std::endl;
-
-	// Construct linear system for decomposition
-	matrix sys(dim, dim);
-	matrix rhs(dim, 1);
-	matrix vars(dim, 1);
-	for (size_t i=0, n=0, f=0; i<yun.size(); i++) {
-		size_t i_expo = to_int(ex_to<numeric>(yun[i].coeff));
-		for (size_t j=0; j<i_expo; j++) {
-			for (size_t k=0; k<size_t(degree(yun[i].rest, x)); k++) {
-				GINAC_ASSERT(n < dim  &&  f < factor.size());
-
-				// column n of coefficient matrix
-				for (size_t r=0; r+k<dim; r++) {
-					sys(r+k, n) = cofac[f].coeff(x, r);
-				}
 
-				// element n of right hand side vector
-				rhs(n, 0) = red_numer.coeff(x, n);
+	// The rest of the denominator is free of x
+	const ex c = (denom.expand().lcoeff(x) / prod.expand().lcoeff(x)).normal();
 
-				// element n of free variables vector
-				vars(n, 0) = symbol();
+	return parfrac_over_factors(numer, c, factors, x);
+}
 
-				n++;
-			}
-			f++;
-		}
+// Rational function of the expression e built from its sums, products and
+// integer powers, so that the denominators are never multiplied out
+static ratfunc parfrac_ratfunc(const ex & e)
+{
+	if (e.info(info_flags::polynomial))
+		return ratfunc(e);
+	if (is_exactly_a<add>(e)) {
+		ratfunc r;
+		for (size_t i = 0; i < e.nops(); ++i)
+			r += parfrac_ratfunc(e.op(i));
+		return r;
 	}
-//std::clog << "coeffs: " << sys << std::endl;
-//std::clog << "rhs   : " << rhs << std::endl;
-
-	// Solve resulting linear system and sum up decomposed fractions
-	matrix sol = sys.solve(vars, rhs);
-//std::clog << "sol   : " << sol << std::endl;
-	ex sum = red_poly;
-	for (size_t i=0, n=0, f=0; i<yun.size(); i++) {
-		size_t i_expo = to_int(ex_to<numeric>(yun[i].coeff));
-		for (size_t j=0; j<i_expo; j++) {
-			ex frac_numer = 0;
-			for (size_t k=0; k<size_t(degree(yun[i].rest, x)); k++) {
-				GINAC_ASSERT(n < dim  &&  f < factor.size());
-				frac_numer += sol(n, 0) * pow(x, k);
-				n++;
-			}
-			sum += frac_numer / factor[f];
-
-			f++;
+	if (is_exactly_a<mul>(e)) {
+		ratfunc r(_ex1);
+		for (size_t i = 0; i < e.nops(); ++i)
+			r *= parfrac_ratfunc(e.op(i));
+		return r;
+	}
+	if (is_exactly_a<power>(e) && e.op(1).info(info_flags::integer)) {
+		ratfunc b = parfrac_ratfunc(e.op(0));
+		int k = ex_to<numeric>(e.op(1)).to_int();
+		if (k < 0) {
+			b = b.inverse();
+			k = -k;
 		}
+		ratfunc r(_ex1);
+		for (; k > 0; k >>= 1) {
+			if (k & 1)
+				r *= b;
+			if (k > 1)
+				b *= b;
+		}
+		return r;
 	}
+	return ratfunc(e);
+}
 
-	return sum;
+/** Compute the partial fraction decomposition of the rational function a
+ *  with respect to x.  The coefficients may be rational functions of other
+ *  symbols.  The denominator is split into pairwise coprime square-free
+ *  factors as far as it is factored in the input (or by square-free
+ *  factorization), the factors are not factored any further.
+ *
+ *  @param a rational function
+ *  @param x variable of the decomposition
+ *  @return polynomial part plus a sum of fractions r(x)/f(x)^j with
+ *          deg(r) < deg(f)
+ *  @exception invalid_argument (a is not a rational function) */
+ex parfrac(const ex & a, const symbol & x)
+{
+	const ratfunc r = parfrac_ratfunc(a);
+	std::vector<std::pair<ex, int>> factors;
+	ex c = _ex1;
+	for (auto & it : r.denom_factors()) {
+		if (it.first.degree(x) > 0)
+			factors.push_back(it);
+		else
+			c *= pow(it.first, it.second);
+	}
+	return parfrac_over_factors(r.numer(), c, factors, x);
 }
 
 
@@ -2207,6 +2681,56 @@ static ex replace_with_symbol(const ex & e, exmap & repl)
 }
 
 
+/** Append the simultaneous substitution m to the sequence steps.  If both m
+ *  and the last step only substitute symbols, the two are composed into one
+ *  map by substituting m into the values of the last step, which only
+ *  traverses the small replacement expressions.  A substitution of another
+ *  expression (the base of a power, see replace_with_symbol()) has to be
+ *  applied on its own.
+ *  @see compose_substitutions */
+static void append_substitution(std::vector<exmap> & steps, bool & last_symbolic, const exmap & m)
+{
+	bool symbolic = true;
+	for (auto & it : m)
+		if (!is_a<symbol>(it.first))
+			symbolic = false;
+	if (!symbolic || !last_symbolic) {
+		steps.push_back(m);
+		last_symbolic = symbolic;
+		return;
+	}
+	for (auto & it : steps.back())
+		it.second = it.second.subs(m, subs_options::no_pattern);
+	for (auto & it : m)
+		steps.back().insert(it);
+}
+
+/** Compose the substitutions of the list modifier from position start on,
+ *  followed by the simultaneous substitution repl, into as few simultaneous
+ *  substitutions as possible, so that a large normalized expression is not
+ *  traversed once for every modifier.
+ *  @see apply_substitutions */
+static std::vector<exmap> compose_substitutions(const lst & modifier, size_t start,
+                                                const exmap & repl = exmap())
+{
+	std::vector<exmap> steps;
+	bool last_symbolic = false;
+	for (size_t i = start; i < modifier.nops(); ++i)
+		append_substitution(steps, last_symbolic, exmap{{modifier.op(i).op(0), modifier.op(i).op(1)}});
+	if (!repl.empty())
+		append_substitution(steps, last_symbolic, repl);
+	return steps;
+}
+
+/** Apply the substitutions composed by compose_substitutions() to e. */
+static ex apply_substitutions(const ex & e, const std::vector<exmap> & steps)
+{
+	ex result = e;
+	for (auto & m : steps)
+		result = result.subs(m, subs_options::no_pattern);
+	return result;
+}
+
 /** Function object to be applied by basic::normal(). */
 struct normal_map_function : public map_function {
 	ex operator()(const ex & e) override { return normal(e); }
@@ -2223,11 +2747,8 @@ ex basic::normal(exmap & repl, exmap & rev_lookup, lst & modifier) const
 	normal_map_function map_normal;
 	size_t nmod = modifier.nops(); // To watch new modifiers to the replacement list
 	ex result = replace_with_symbol(map(map_normal), repl, rev_lookup, modifier);
-	for (size_t imod = nmod; imod < modifier.nops(); ++imod) {
-		exmap this_repl;
-		this_repl.insert(std::make_pair(modifier.op(imod).op(0), modifier.op(imod).op(1)));
-		result = result.subs(this_repl, subs_options::no_pattern);
-	}
+	if (modifier.nops() > nmod)
+		result = apply_substitutions(result, compose_substitutions(modifier, nmod));
 
 	// Sometimes we may obtain negative powers, they need to be placed to denominator
 	if (is_a<power>(result) && result.op(1).info(info_flags::negative))
@@ -2354,40 +2875,60 @@ ex add::normal(exmap & repl, exmap & rev_lookup, lst & modifier) const
 	// all denominators
 //std::clog << "add::normal uses " << nums.size() << " summands:\n";
 
-	// Add fractions sequentially
-	auto num_it = nums.begin(), num_itend = nums.end();
-	auto den_it = dens.begin(), den_itend = dens.end();
-//std::clog << " num = " << *num_it << ", den = " << *den_it << std::endl;
-	for (size_t imod = nmod; imod < modifier.nops(); ++imod) {
-		while (num_it != num_itend) {
-			*num_it = num_it->subs(modifier.op(imod), subs_options::no_pattern);
-			++num_it;
-			*den_it = den_it->subs(modifier.op(imod), subs_options::no_pattern);
-			++den_it;
+	if (modifier.nops() > nmod) {
+		const std::vector<exmap> steps = compose_substitutions(modifier, nmod);
+		for (size_t i = 0; i < nums.size(); ++i) {
+			nums[i] = apply_substitutions(nums[i], steps);
+			dens[i] = apply_substitutions(dens[i], steps);
 		}
-		// Reset iterators for the next round
-		num_it = nums.begin();
-		den_it = dens.begin();
 	}
 
-	ex num = *num_it++, den = *den_it++;
-	while (num_it != num_itend) {
-//std::clog << " num = " << *num_it << ", den = " << *den_it << std::endl;
-		ex next_num = *num_it++, next_den = *den_it++;
-
-		// Trivially add sequences of fractions with identical denominators
-		while ((den_it != den_itend) && next_den.is_equal(*den_it)) {
-			next_num += *num_it;
-			num_it++; den_it++;
+	// Trivially add fractions with identical denominators
+	std::vector<exvector> group_nums;
+	exvector group_dens;
+	std::map<ex, size_t, ex_is_less> group_of;
+	for (size_t i = 0; i < nums.size(); ++i) {
+		if (nums[i].is_zero())
+			continue;
+		auto ins = group_of.insert(std::make_pair(dens[i], group_dens.size()));
+		if (ins.second) {
+			group_nums.push_back(exvector());
+			group_dens.push_back(dens[i]);
 		}
-
-		// Addition of two fractions, taking advantage of the fact that
-		// the heuristic GCD algorithm computes the cofactors at no extra cost
-		ex co_den1, co_den2;
-		ex g = gcd(den, next_den, &co_den1, &co_den2, false);
-		num = ((num * co_den2) + (next_num * co_den1)).expand();
-		den *= co_den2;		// this is the lcm(den, next_den)
+		group_nums[ins.first->second].push_back(nums[i]);
+	}
+	if (group_dens.empty())
+		return dynallocate<lst>({_ex0, _ex1});
+	nums.clear();
+	for (auto & g : group_nums)
+		nums.push_back(g.size() == 1 ? g[0] : dynallocate<add>(g).expand());
+	dens.swap(group_dens);
+
+	// Add the fractions pairwise in a balanced tree instead of adding them
+	// one by one to a growing sum: the operands of every addition then have
+	// comparable sizes, and every numerator is multiplied by O(log n)
+	// cofactors only.  The common denominators stay products of the
+	// cofactors, so the GCDs further up the tree can work factor by factor.
+	while (nums.size() > 1) {
+		size_t j = 0;
+		for (size_t i = 0; i + 1 < nums.size(); i += 2, ++j) {
+			// Addition of two fractions, taking advantage of the fact that
+			// the heuristic GCD algorithm computes the cofactors at no extra cost
+			ex co_den1, co_den2;
+			ex g = gcd(dens[i], dens[i+1], &co_den1, &co_den2, false);
+			nums[j] = ((nums[i] * co_den2) + (nums[i+1] * co_den1)).expand();
+			dens[j] = dens[i] * co_den2;	// this is the lcm(dens[i], dens[i+1])
+		}
+		if (nums.size() % 2) {
+			nums[j] = nums.back();
+			dens[j] = dens.back();
+			++j;
+		}
+		nums.resize(j);
+		dens.resize(j);
 	}
+	const ex & num = nums[0];
+	const ex & den = dens[0];
 //std::clog << " common denominator = " << den << std::endl;
 
 	// Cancel common factors from num/den
@@ -2413,17 +2954,12 @@ ex mul::normal(exmap & repl, exmap & rev_lookup, lst & modifier) const
 	n = ex_to<numeric>(overall_coeff).normal(repl, rev_lookup, modifier);
 	num.push_back(n.op(0));
 	den.push_back(n.op(1));
-	auto num_it = num.begin(), num_itend = num.end();
-	auto den_it = den.begin();
-	for (size_t imod = nmod; imod < modifier.nops(); ++imod) {
-		while (num_it != num_itend) {
-			*num_it = num_it->subs(modifier.op(imod), subs_options::no_pattern);
-			++num_it;
-			*den_it = den_it->subs(modifier.op(imod), subs_options::no_pattern);
-			++den_it;
+	if (modifier.nops() > nmod) {
+		const std::vector<exmap> steps = compose_substitutions(modifier, nmod);
+		for (size_t i = 0; i < num.size(); ++i) {
+			num[i] = apply_substitutions(num[i], steps);
+			den[i] = apply_substitutions(den[i], steps);
 		}
-		num_it = num.begin();
-		den_it = den.begin();
 	}
 
 	// Perform fraction cancellation
@@ -2440,13 +2976,13 @@ ex power::normal(exmap & repl, exmap & rev_lookup, lst & modifier) const
 	// Normalize basis and exponent (exponent gets reassembled)
 	size_t nmod = modifier.nops(); // To watch new modifiers to the replacement list
 	ex n_basis = ex_to<basic>(basis).normal(repl, rev_lookup, modifier);
-	for (size_t imod = nmod; imod < modifier.nops(); ++imod)
-		n_basis = n_basis.subs(modifier.op(imod), subs_options::no_pattern);
+	if (modifier.nops() > nmod)
+		n_basis = apply_substitutions(n_basis, compose_substitutions(modifier, nmod));
 
 	nmod = modifier.nops();
 	ex n_exponent = ex_to<basic>(exponent).normal(repl, rev_lookup, modifier);
-	for (size_t imod = nmod; imod < modifier.nops(); ++imod)
-		n_exponent = n_exponent.subs(modifier.op(imod), subs_options::no_pattern);
+	if (modifier.nops() > nmod)
+		n_exponent = apply_substitutions(n_exponent, compose_substitutions(modifier, nmod));
 	n_exponent = n_exponent.op(0) / n_exponent.op(1);
 
 	if (n_exponent.info(info_flags::integer)) {
@@ -2525,11 +3061,8 @@ ex ex::normal() const
 	GINAC_ASSERT(is_a<lst>(e));
 
 	// Re-insert replaced symbols
-	if (!repl.empty()) {
-		for(size_t i=0; i < modifier.nops(); ++i)
-			e = e.subs(modifier.op(i), subs_options::no_pattern);
-		e = e.subs(repl, subs_options::no_pattern);
-	}
+	if (!repl.empty())
+		e = apply_substitutions(e, compose_substitutions(modifier, 0, repl));
 
 	// Convert {numerator, denominator} form back to fraction
 	return e.op(0) / e.op(1);
@@ -2552,12 +3085,8 @@ ex ex::numer() const
 	// Re-insert replaced symbols
 	if (repl.empty())
 		return e.op(0);
-	else {
-		for(size_t i=0; i < modifier.nops(); ++i)
-			e = e.subs(modifier.op(i), subs_options::no_pattern);
-
-		return e.op(0).subs(repl, subs_options::no_pattern);
-	}
+	else
+		return apply_substitutions(e.op(0), compose_substitutions(modifier, 0, repl));
 }
 
 /** Get denominator of an expression. If the expression is not of the normal
@@ -2577,12 +3106,8 @@ ex ex::denom() const
 	// Re-insert replaced symbols
 	if (repl.empty())
 		return e.op(1);
-	else {
-		for(size_t i=0; i < modifier.nops(); ++i)
-			e = e.subs(modifier.op(i), subs_options::no_pattern);
-
-		return e.op(1).subs(repl, subs_options::no_pattern);
-	}
+	else
+		return apply_substitutions(e.op(1), compose_substitutions(modifier, 0, repl));
 }
 
 /** Get numerator and denominator of an expression. If the expression is not
@@ -2602,12 +3127,8 @@ ex ex::numer_denom() const
 	// Re-insert replaced symbols
 	if (repl.empty())
 		return e;
-	else {
-		for(size_t i=0; i < modifier.nops(); ++i)
-			e = e.subs(modifier.op(i), subs_options::no_pattern);
-
-		return e.subs(repl, subs_options::no_pattern);
-	}
+	else
+		return apply_substitutions(e, compose_substitutions(modifier, 0, repl));
 }
 
 
@@ -2787,9 +3308,14 @@ static ex find_common_factor(const ex & e, ex & factor, exmap & repl)
 
 			if (gc.is_zero())
 				gc = x;
-			else
+			else if (!gc.is_equal(x))
 				gc = gcd(gc, x);
 
+			// Once the GCD is trivial the remaining terms need not be
+			// looked at, nothing is going to be pulled out
+			if (gc.is_equal(_ex1))
+				return e;
+
 			terms.push_back(x);
 		}
 
@@ -2873,8 +3399,62 @@ ex collect_common_factors(const ex & e)
 }
 
 
+// Polynomial in x with the given numeric coefficients (used internally by
+// determinant_by_interpolation() and interpolation_polynomial())
+static ex numeric_coeffs_to_poly(const std::vector<cln::cl_N> & c, const ex & x)
+{
+	exvector terms;
+	terms.reserve(c.size());
+	for (size_t i = 0; i < c.size(); ++i) {
+		if (!cln::zerop(c[i]))
+			terms.push_back(numeric(c[i]) * pow(x, i));
+	}
+	return dynallocate<add>(terms);
+}
+
+/** Determinant of a matrix whose entries are polynomials in the symbol y
+ *  with rational coefficients, given a bound deg for the degree of the
+ *  determinant in y.  The distinct entries are evaluated at the points
+ *  0..deg by a subproduct tree, the numeric determinants are computed and
+ *  the result is interpolated with the same tree. */
+static ex determinant_by_interpolation(const matrix & m, const ex & y, int deg)
+{
+	std::vector<cln::cl_N> pts;
+	pts.reserve(deg + 1);
+	for (int k = 0; k <= deg; ++k)
+		pts.push_back(cln::cl_I(k));
+	const subproduct_tree<std::vector<cln::cl_N>> tree(pts);
+
+	std::vector<matrix> images(deg + 1, matrix(m.rows(), m.cols()));
+	std::map<ex, std::vector<cln::cl_N>, ex_is_less> entry_values;
+	for (unsigned r = 0; r < m.rows(); ++r) {
+		for (unsigned c = 0; c < m.cols(); ++c) {
+			const ex & e = m(r, c);
+			if (e.is_zero())
+				continue;
+			auto it = entry_values.find(e);
+			if (it == entry_values.end()) {
+				std::vector<cln::cl_N> p(e.degree(y) + 1);
+				for (size_t k = 0; k < p.size(); ++k)
+					p[k] = ex_to<numeric>(e.coeff(y, k)).to_cl_N();
+				canonicalize(p);
+				it = entry_values.insert(std::make_pair(e, tree.evaluate(p))).first;
+			}
+			for (int k = 0; k <= deg; ++k)
+				images[k](r, c) = numeric(it->second[k]);
+		}
+	}
+
+	std::vector<cln::cl_N> dets;
+	dets.reserve(deg + 1);
+	for (auto & im : images)
+		dets.push_back(ex_to<numeric>(im.determinant()).to_cl_N());
+	return numeric_coeffs_to_poly(tree.interpolate(dets), y);
+}
+
 /** Resultant of two expressions e1,e2 with respect to symbol s.
- *  Method: Compute determinant of Sylvester matrix of e1,e2,s.  */
+ *  Method: Compute determinant of Sylvester matrix of e1,e2,s (by
+ *  evaluation and interpolation if there is one other symbol).  */
 ex resultant(const ex & e1, const ex & e2, const ex & s)
 {
 	const ex ee1 = e1.expand();
@@ -2902,8 +3482,109 @@ ex resultant(const ex & e1, const ex & e2, const ex & s)
 			m(k+h2, k+h2-l) = e;
 	}
 
+	// Bivariate polynomials with rational coefficients: the resultant is
+	// a polynomial in the other symbol of known degree bound, interpolate
+	// it from numeric determinants
+	sym_desc_vec sdv;
+	get_symbol_stats(ee1, ee2, sdv);
+	if (msize > 0 && sdv.size() == 2 &&
+	    ee1.info(info_flags::rational_polynomial) &&
+	    ee2.info(info_flags::rational_polynomial)) {
+		const sym_desc & y = sdv[0].sym.is_equal(s) ? sdv[1] : sdv[0];
+		return determinant_by_interpolation(m, y.sym, h2*y.deg_a + h1*y.deg_b);
+	}
+
 	return m.determinant();
 }
 
 
+/** Polynomial of lowest degree in x that takes the given values at the given
+ *  points.  The product of the linear factors x - point is built as a
+ *  subproduct tree, which is used both to compute the Lagrange weights and
+ *  to combine the Lagrange terms.
+ *
+ *  @param points  list of pairwise distinct numbers
+ *  @param values  list of numbers, one for each point
+ *  @param x  the variable of the result
+ *  @return polynomial in x of degree less than the number of points
+ *  @exception invalid_argument (points and values are not lists of numbers
+ *             of the same length, or the points are not distinct) */
+ex interpolation_polynomial(const ex & points, const ex & values, const ex & x)
+{
+	if (!is_a<lst>(points) || !is_a<lst>(values) ||
+	    points.nops() != values.nops() || points.nops() == 0)
+		throw std::invalid_argument("interpolation_polynomial(): points and values must be non-empty lists of the same length");
+	if (!is_a<symbol>(x))
+		throw std::invalid_argument("interpolation_polynomial(): third argument must be a symbol");
+
+	std::vector<cln::cl_N> pts, vals;
+	pts.reserve(points.nops());
+	vals.reserve(values.nops());
+	for (size_t i = 0; i < points.nops(); ++i) {
+		if (!is_a<numeric>(points.op(i)) || !is_a<numeric>(values.op(i)))
+			throw std::invalid_argument("interpolation_polynomial(): points and values must be numbers");
+		pts.push_back(ex_to<numeric>(points.op(i)).to_cl_N());
+		vals.push_back(ex_to<numeric>(values.op(i)).to_cl_N());
+	}
+	const subproduct_tree<std::vector<cln::cl_N>> tree(pts);
+	return numeric_coeffs_to_poly(tree.interpolate(vals), x);
+}
+
+
+/** Normal form of a rational function, computed without expanding any
+ *  intermediate numerators.  Non-rational subexpressions are replaced by
+ *  temporary symbols as in to_rational().  The expression is evaluated at
+ *  random points modulo primes, and numerator and denominator are
+ *  reconstructed by sparse rational interpolation, so the cost depends on
+ *  the size of the result rather than on the size of the expression once
+ *  expanded.  The algorithm is probabilistic: the result is checked at
+ *  random points, but not proven.
+ *
+ *  @param e  expression to be normalized
+ *  @return normalized expression numer/denom like from ex::normal(), with
+ *          integer coefficients and a unit normal denominator
+ *  @exception invalid_argument (e contains numbers that are not rational)
+ *  @exception pole_error (the denominator of e vanishes identically) */
+ex normal_by_interpolation(const ex & e)
+{
+	exmap repl;
+	const ex r = e.to_rational(repl);
+	exvector vars;
+	collect_symbols(r, vars);
+	if (vars.empty())
+		return e.normal();
+
+	ex num, den;
+	ratinterp_normal(num, den, r, vars);
+	if (num.is_zero())
+		return _ex0;
+
+	// Bring numerator and denominator to Z[X] with coprime coefficients
+	const numeric l = lcm(lcm_of_coefficients_denominators(num),
+	                      lcm_of_coefficients_denominators(den));
+	num = multiply_lcm(num, l);
+	den = multiply_lcm(den, l);
+	const numeric c = gcd(num.integer_content(), den.integer_content());
+	if (!c.is_equal(*_num1_p)) {
+		num = (num / c).expand();
+		den = (den / c).expand();
+	}
+
+	// Make denominator unit normal
+	ex x;
+	if (is_exactly_a<numeric>(den)) {
+		if (ex_to<numeric>(den).is_negative()) {
+			num *= _ex_1;
+			den *= _ex_1;
+		}
+	} else if (get_first_symbol(den, x)) {
+		if (ex_to<numeric>(den.unit(x)).is_negative()) {
+			num *= _ex_1;
+			den *= _ex_1;
+		}
+	}
+	return (num / den).subs(repl, subs_options::no_pattern);
+}
+
+
 } // namespace GiNaC
@@ -97,12 +97,21 @@ extern ex sqrfree(const ex &a, const lst &l = lst());
 // Square-free partial fraction decomposition of a rational function a(x)
 extern ex sqrfree_parfrac(const ex & a, const symbol & x);
 
+// Partial fraction decomposition of a rational function a(x)
+extern ex parfrac(const ex & a, const symbol & x);
+
 // Collect common factors in sums.
 extern ex collect_common_factors(const ex & e);
 
 // Resultant of two polynomials e1,e2 with respect to symbol s.
 extern ex resultant(const ex & e1, const ex & e2, const ex & s);
 
+// Polynomial in x through the given points and values.
+extern ex interpolation_polynomial(const ex & points, const ex & values, const ex & x);
+
+// Normal form of a rational function by evaluation and sparse interpolation modulo primes.
+extern ex normal_by_interpolation(const ex & e);
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_NORMAL_H
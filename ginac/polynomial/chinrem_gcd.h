@@ -27,7 +27,8 @@
 
 namespace GiNaC {
 
-extern ex chinrem_gcd(const ex& A_, const ex& B_, const exvector& vars);
+extern ex chinrem_gcd(const ex& A_, const ex& B_, const exvector& vars,
+		      bool sparse = false);
 extern ex chinrem_gcd(const ex& A, const ex& B);
 
 struct chinrem_gcd_failed
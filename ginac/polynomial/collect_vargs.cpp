@@ -22,6 +22,7 @@
 
 #include "add.h"
 #include "mul.h"
+#include "numeric.h"
 #include "operators.h"
 #include "power.h"
 #include "collect_vargs.h"
@@ -37,13 +38,14 @@
 
 namespace GiNaC {
 
-typedef std::map<exp_vector_t, ex> ex_collect_priv_t;
+// Coefficients are accumulated per exponent vector and summed up only once
+// at the end: adding them one by one would rebuild a growing sum each time.
+typedef std::map<exp_vector_t, exvector> ex_collect_priv_t;
 
 static void 
 collect_vargs(ex_collect_priv_t& ec, ex e, const exvector& vars);
 static void
 collect_term(ex_collect_priv_t& ec, const ex& e, const exvector& vars);
-static void wipe_out_zeros(ex_collect_priv_t& ec);
 
 template<typename T, typename CoeffCMP>
 struct compare_terms
@@ -80,7 +82,11 @@ void collect_vargs(ex_collect_t& ec, const ex& e, const exvector& vars)
 	ex_collect_priv_t ecp;
 	collect_vargs(ecp, e, vars);
 	ec.reserve(ecp.size());
-	std::copy(ecp.begin(), ecp.end(), std::back_inserter(ec));
+	for (auto & i : ecp) {
+		ex c = dynallocate<add>(i.second);
+		if (!c.is_zero())
+			ec.push_back(std::make_pair(i.first, c));
+	}
 	std::sort(ec.begin(), ec.end(),
 		  make_compare_terms(*ec.begin(), ex_is_less()));
 }
@@ -101,8 +107,6 @@ collect_vargs(ex_collect_priv_t& ec, ex e, const exvector& vars)
 
 	for (const_iterator i = e.begin(); i != e.end(); ++i)
 		collect_term(ec, *i, vars);
-
-	wipe_out_zeros(ec);
 }
 
 static void
@@ -110,33 +114,53 @@ collect_term(ex_collect_priv_t& ec, const ex& e, const exvector& vars)
 {
 	if (e.is_zero())
 		return;
-	static const ex ex1(1);
 	exp_vector_t key(vars.size());
-	ex pre_coeff = e;
-	for (std::size_t i = 0; i < vars.size(); ++i) {
-		const int var_i_pow = pre_coeff.degree(vars[i]);
-		key[i] = var_i_pow;
-		pre_coeff = pre_coeff.coeff(vars[i], var_i_pow);
+	ex pre_coeff;
+	if (!split_monomial(e, vars, key, pre_coeff)) {
+		pre_coeff = e;
+		for (std::size_t i = 0; i < vars.size(); ++i) {
+			const int var_i_pow = pre_coeff.degree(vars[i]);
+			key[i] = var_i_pow;
+			pre_coeff = pre_coeff.coeff(vars[i], var_i_pow);
+		}
 	}
-	auto i = ec.find(key);
-	if (i != ec.end())
-		i->second += pre_coeff;
-	else
-		ec.insert(ex_collect_priv_t::value_type(key, pre_coeff));
+	ec[key].push_back(pre_coeff);
 }
 
-static void wipe_out_zeros(ex_collect_priv_t& m)
+bool
+split_monomial(const ex& term, const exvector& vars, exp_vector_t& exps, ex& c)
 {
-	auto i = m.begin();
-	while (i != m.end()) {
-		// be careful to not invalidate the iterator, use post-increment
-		// for that, see e.g.
-		// http://coding.derkeiler.com/Archive/C_CPP/comp.lang.cpp/2004-02/0502.html
-		if (i->second.is_zero())
-			m.erase(i++);
-		else
-			++i;
+	std::fill(exps.begin(), exps.end(), 0);
+	exvector cv;
+	const bool is_product = is_exactly_a<mul>(term);
+	const std::size_t nfactors = is_product ? term.nops() : 1;
+	cv.reserve(nfactors);
+	for (std::size_t k = 0; k < nfactors; ++k) {
+		const ex& f = is_product ? term.op(k) : term;
+		bool matched = false;
+		for (std::size_t i = 0; i < vars.size(); ++i) {
+			if (f.is_equal(vars[i])) {
+				++exps[i];
+				matched = true;
+				break;
+			}
+			if (is_exactly_a<power>(f) && f.op(0).is_equal(vars[i]) &&
+			    f.op(1).info(info_flags::integer)) {
+				exps[i] += ex_to<numeric>(f.op(1)).to_int();
+				matched = true;
+				break;
+			}
+		}
+		if (matched)
+			continue;
+		for (auto & v : vars) {
+			if (f.has(v))
+				return false;
+		}
+		cv.push_back(f);
 	}
+	c = dynallocate<mul>(cv);
+	return true;
 }
 
 ex
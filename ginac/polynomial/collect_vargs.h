@@ -63,6 +63,16 @@ collect_vargs(ex_collect_t& ec, const ex& e, const exvector& x);
 extern ex
 ex_collect_to_ex(const ex_collect_t& ec, const exvector& x);
 
+/**
+ * Split a term of an expanded polynomial into the exponents of the
+ * variables vars and the coefficient c free of them, in a single pass
+ * over its factors. Returns false if some factor depends on the variables
+ * other than through an integer power of one of them (e.g. sin(x) or
+ * (x+1)^2); the caller has to fall back to degree() and coeff() then.
+ */
+extern bool
+split_monomial(const ex& term, const exvector& vars, exp_vector_t& exps, ex& c);
+
 /**
  * Leading coefficient of a multivariate polynomial e, considering it
  * as a multivariate polynomial in x_0, \ldots x_{n-1} with coefficients
@@ -25,6 +25,7 @@
 
 #include "upoly.h"
 #include "remainder.h"
+#include "half_gcd.h"
 #include "normalize.h"
 #include "debug.h"
 #include "upoly_io.h"
@@ -45,6 +46,11 @@ gcd_euclid(umodpoly& c, umodpoly /* passed by value */ a, umodpoly b)
 	bug_on(a[0].ring()->modulus != b[0].ring()->modulus,
 		"different moduli");
 
+	if (std::min(degree(a), degree(b)) >= half_gcd_threshold) {
+		half_gcd(c, a, b);
+		return false;
+	}
+
 	normalize_in_field(a);
 	normalize_in_field(b);
 	if (degree(a) < degree(b))
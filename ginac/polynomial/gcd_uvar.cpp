@@ -20,10 +20,21 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include "gcd_uvar.h"
 #include "upoly.h"
 #include "sr_gcd_uvar.h"
 #include "heur_gcd_uvar.h"
+#include "gcd_euclid.h"
+#include "smod_helpers.h"
+#include "add.h"
+#include "mul.h"
+#include "numeric.h"
+#include "operators.h"
+#include "power.h"
+#include "symbol.h"
 
+#include <algorithm>
+#include <map>
 #include <stdexcept>
 
 namespace GiNaC {
@@ -43,6 +54,240 @@ bool heur_gcd_z(upoly& g, const upoly& a, const upoly& b)
 	return heur_gcd_z_priv(g, a, b);
 }
 
+/// Word-sized prime used for the degree bounds of the GCD.
+static const long degree_bound_prime = 2147483647;
+
+/// Degree of the GCD of a and b modulo degree_bound_prime. This is an upper
+/// bound of the degree of the GCD over Z, unless the prime divides one of
+/// the leading coefficients; the degree of the smaller input is returned
+/// in that case.
+static std::size_t gcd_degree_bound(const upoly& a, const upoly& b)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(degree_bound_prime);
+	umodpoly am(a.size()), bm(b.size());
+	make_umodpoly(am, a, R);
+	make_umodpoly(bm, b, R);
+	if (am.size() != a.size() || bm.size() != b.size())
+		return std::min(degree(a), degree(b));
+	umodpoly g;
+	gcd_euclid(g, am, bm);
+	return degree(g);
+}
+
+static cln::cl_I max_abs_coeff(const upoly& p)
+{
+	cln::cl_I m = 0;
+	for (std::size_t i = p.size(); i-- != 0; )
+		m = cln::max(m, cln::abs(p[i]));
+	return m;
+}
+
+/// Exact division of univariate polynomials over Z. Returns false if b
+/// does not divide a.
+static bool divide_exact(upoly& q, const upoly& a, const upoly& b)
+{
+	bug_on(b.empty(), "division by zero");
+	if (a.empty()) {
+		q.clear();
+		return true;
+	}
+	if (a.size() < b.size())
+		return false;
+
+	const std::size_t n = degree(b);
+	upoly r(a);
+	q.assign(a.size() - n, cln::cl_I(0));
+	for (std::size_t k = a.size(); k-- > n; ) {
+		if (zerop(r[k]))
+			continue;
+		cln::cl_I qk;
+		if (!div(qk, r[k], lcoeff(b)))
+			return false;
+		q[k - n] = qk;
+		for (std::size_t i = 0; i <= n; ++i)
+			r[k - n + i] = r[k - n + i] - qk*b[i];
+	}
+	canonicalize(r);
+	if (!r.empty())
+		return false;
+	canonicalize(q);
+	return true;
+}
+
+bool heur_gcd_z(upoly& g, upoly& ca, upoly& cb, const upoly& a, const upoly& b)
+{
+	bug_on(a.empty() || b.empty(), "heur_gcd_z: zero input polynomial");
+	upoly a_(a), b_(b);
+	cln::cl_I acont, bcont;
+	int aunit = 1, bunit = 1;
+	normalize_in_ring(a_, &acont, &aunit);
+	normalize_in_ring(b_, &bcont, &bunit);
+	const cln::cl_I gc = cln::gcd(acont, bcont);
+
+	upoly gg, qa, qb;
+	const std::size_t bound = gcd_degree_bound(a_, b_);
+	if (bound == 0) {
+		// coprime primitive parts, no need to evaluate anything
+		gg.assign(1, cln::cl_I(1));
+		qa = a_;
+		qb = b_;
+	} else {
+		static const cln::cl_I n73794(73794), n27011(27011);
+		const std::size_t maxdeg = std::max(degree(a_), degree(b_));
+		cln::cl_I xi = (std::min(max_abs_coeff(a_), max_abs_coeff(b_)) + 1) << 1;
+		bool found = false;
+		// 6 tries maximum, and give up before the evaluations get huge
+		for (unsigned t = 0; t < 6 && !found; ++t) {
+			if (cln::integer_length(xi) * maxdeg > 100000)
+				return false;
+			const cln::cl_I gamma = cln::gcd(eval(a_, xi), eval(b_, xi));
+			interpolate(gg, gamma, xi, maxdeg);
+			normalize_in_ring(gg);
+			// Candidates exceeding the modular bound are certainly
+			// wrong, don't waste trial divisions on them
+			if (!gg.empty() && degree(gg) <= bound)
+				found = divide_exact(qa, a_, gg) && divide_exact(qb, b_, gg);
+			xi = cln::truncate1(xi*cln::isqrt(cln::isqrt(xi))*n73794, n27011);
+		}
+		if (!found)
+			return false;
+	}
+
+	g = gg;
+	g *= gc;
+	ca = qa;
+	ca *= cln::exquo(acont, gc) * aunit;
+	cb = qb;
+	cb *= cln::exquo(bcont, gc) * bunit;
+	return true;
+}
+
+// Multiply a monomial of an expanded integer polynomial into the image of
+// that polynomial modulo a prime with all variables but x evaluated (used
+// internally by modular_image())
+static bool add_image_term(umodpoly& u, const ex& t, const ex& x,
+			   std::map<ex, cln::cl_MI, ex_is_less>& point,
+			   const cln::cl_modint_ring& R, int& deg)
+{
+	cln::cl_MI c = R->one();
+	int k = 0;
+	const bool is_product = is_exactly_a<mul>(t);
+	const std::size_t nfactors = is_product ? t.nops() : 1;
+	for (std::size_t i = 0; i < nfactors; ++i) {
+		const ex& f = is_product ? t.op(i) : t;
+		if (is_exactly_a<numeric>(f)) {
+			if (!f.info(info_flags::integer))
+				return false;
+			c = c * R->canonhom(to_cl_I(f));
+			continue;
+		}
+		ex base = f;
+		int n = 1;
+		if (is_exactly_a<power>(f)) {
+			if (!f.op(1).info(info_flags::posint))
+				return false;
+			base = f.op(0);
+			n = ex_to<numeric>(f.op(1)).to_int();
+		}
+		if (base.is_equal(x)) {
+			k += n;
+			continue;
+		}
+		if (!is_a<symbol>(base))
+			return false;
+		auto it = point.find(base);
+		if (it == point.end()) {
+			// fixed pseudo-random evaluation point, an unlucky one
+			// only makes the bound useless, never wrong
+			const cln::cl_I v = cln::mod(cln::cl_I(48271) * cln::cl_I(long(point.size() + 1)) + 11, degree_bound_prime);
+			it = point.insert(std::make_pair(base, R->canonhom(v))).first;
+		}
+		c = c * cln::expt_pos(it->second, n);
+	}
+	if (u.size() <= std::size_t(k))
+		u.resize(k + 1, R->zero());
+	u[k] = u[k] + c;
+	deg = std::max(deg, k);
+	return true;
+}
+
+// Image of an expanded integer polynomial modulo a prime with all variables
+// but x evaluated. deg is set to the degree of e in x.
+static bool modular_image(umodpoly& u, const ex& e, const ex& x,
+			  std::map<ex, cln::cl_MI, ex_is_less>& point,
+			  const cln::cl_modint_ring& R, int& deg)
+{
+	u.clear();
+	deg = 0;
+	if (is_exactly_a<add>(e)) {
+		for (std::size_t i = 0; i < e.nops(); ++i) {
+			if (!add_image_term(u, e.op(i), x, point, R, deg))
+				return false;
+		}
+	} else if (!add_image_term(u, e, x, point, R, deg))
+		return false;
+	canonicalize(u);
+	return true;
+}
+
+int gcd_degree_bound(const ex& a, const ex& b, const ex& x)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(degree_bound_prime);
+	std::map<ex, cln::cl_MI, ex_is_less> point;
+	umodpoly ua, ub;
+	int dega, degb;
+	if (!modular_image(ua, a, x, point, R, dega) ||
+	    !modular_image(ub, b, x, point, R, degb))
+		return -1;
+	if (ua.empty() || ub.empty() || int(degree(ua)) != dega || int(degree(ub)) != degb)
+		return -1;
+	umodpoly g;
+	gcd_euclid(g, ua, ub);
+	return degree(g);
+}
+
+bool to_upoly(upoly& u, const ex& e, const ex& x)
+{
+	u.clear();
+	const bool is_sum = is_exactly_a<add>(e);
+	const std::size_t nterms = is_sum ? e.nops() : 1;
+	for (std::size_t i = 0; i < nterms; ++i) {
+		const ex& t = is_sum ? e.op(i) : e;
+		cln::cl_I c = 1;
+		std::size_t k = 0;
+		const bool is_product = is_exactly_a<mul>(t);
+		const std::size_t nfactors = is_product ? t.nops() : 1;
+		for (std::size_t j = 0; j < nfactors; ++j) {
+			const ex& f = is_product ? t.op(j) : t;
+			if (is_exactly_a<numeric>(f) && f.info(info_flags::integer))
+				c = c * to_cl_I(f);
+			else if (f.is_equal(x))
+				++k;
+			else if (is_exactly_a<power>(f) && f.op(0).is_equal(x) &&
+				 f.op(1).info(info_flags::posint))
+				k += ex_to<numeric>(f.op(1)).to_int();
+			else
+				return false;
+		}
+		if (u.size() <= k)
+			u.resize(k + 1, cln::cl_I(0));
+		u[k] = u[k] + c;
+	}
+	canonicalize(u);
+	return true;
+}
+
+ex from_upoly(const upoly& u, const ex& x)
+{
+	exvector ev;
+	ev.reserve(u.size());
+	for (std::size_t i = u.size(); i-- != 0; ) {
+		if (!zerop(u[i]))
+			ev.push_back(numeric(u[i]) * pow(x, i));
+	}
+	return dynallocate<add>(ev);
+}
+
 upoly pseudoremainder(const upoly& a, const upoly& b)
 {
 	upoly r;
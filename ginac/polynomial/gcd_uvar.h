@@ -0,0 +1,61 @@
+/** @file gcd_uvar.h
+ *
+ *  Interface to GCD functions for univariate polynomials. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_GCD_UVAR_H
+#define GINAC_GCD_UVAR_H
+
+#include "upoly.h"
+#include "ex.h"
+
+namespace GiNaC {
+
+extern upoly sr_gcd(const upoly& a, const upoly& b);
+extern bool heur_gcd_z(upoly& g, const upoly& a, const upoly& b);
+
+/**
+ * Heuristic GCD of univariate integer polynomials, also computing the
+ * cofactors ca = a/g and cb = b/g. The degree of the GCD is bounded by
+ * a GCD computation modulo a word-sized prime first: if the bound is zero
+ * the answer is known right away, and candidates exceeding it are
+ * rejected without trial division. Returns false if no GCD was found.
+ */
+extern bool heur_gcd_z(upoly& g, upoly& ca, upoly& cb,
+		       const upoly& a, const upoly& b);
+
+/**
+ * Upper bound for the degree in x of the GCD of the expanded integer
+ * polynomials a and b, obtained by evaluating all other variables modulo
+ * a word-sized prime. Returns -1 if no bound could be found (e.g. the
+ * leading coefficient vanishes at the evaluation point).
+ */
+extern int gcd_degree_bound(const ex& a, const ex& b, const ex& x);
+
+/**
+ * Convert an expanded polynomial in Z[x] into a dense coefficient vector.
+ * Returns false if e contains anything but integers and powers of x.
+ */
+extern bool to_upoly(upoly& u, const ex& e, const ex& x);
+extern ex from_upoly(const upoly& u, const ex& x);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_GCD_UVAR_H
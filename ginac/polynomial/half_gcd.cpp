@@ -0,0 +1,150 @@
+/** @file half_gcd.cpp
+ *
+ *  GCD of univariate polynomials over Z_p by the half-GCD algorithm. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "half_gcd.h"
+#include "multipoint.h"
+#include "normalize.h"
+#include "remainder.h"
+#include "debug.h"
+
+namespace GiNaC {
+
+/// Below this degree hgcd() performs the quotient steps one by one.
+static const std::size_t hgcd_base_degree = 48;
+
+/// Product of the quotient matrices ((0, 1), (1, -q)) of a part of a
+/// remainder sequence.
+struct hgcd_matrix
+{
+	umodpoly m00, m01, m10, m11;
+};
+
+static hgcd_matrix identity_matrix(const cln::cl_MI& sample)
+{
+	hgcd_matrix m;
+	m.m00 = umodpoly(1, the_one(sample));
+	m.m11 = m.m00;
+	return m;
+}
+
+// s t
+static hgcd_matrix operator*(const hgcd_matrix& s, const hgcd_matrix& t)
+{
+	hgcd_matrix m;
+	m.m00 = poly_add(poly_mul(s.m00, t.m00), poly_mul(s.m01, t.m10));
+	m.m01 = poly_add(poly_mul(s.m00, t.m01), poly_mul(s.m01, t.m11));
+	m.m10 = poly_add(poly_mul(s.m10, t.m00), poly_mul(s.m11, t.m10));
+	m.m11 = poly_add(poly_mul(s.m10, t.m01), poly_mul(s.m11, t.m11));
+	return m;
+}
+
+// (c, d) = m (a, b)
+static void apply(umodpoly& c, umodpoly& d, const hgcd_matrix& m,
+		  const umodpoly& a, const umodpoly& b)
+{
+	c = poly_add(poly_mul(m.m00, a), poly_mul(m.m01, b));
+	d = poly_add(poly_mul(m.m10, a), poly_mul(m.m11, b));
+}
+
+// a div x^k
+static umodpoly shift_down(const umodpoly& a, const std::size_t k)
+{
+	if (a.size() <= k)
+		return umodpoly();
+	return umodpoly(a.begin() + k, a.end());
+}
+
+// One step of the remainder sequence, (c, d) <- (d, c mod d), with the
+// quotient matrix multiplied into m from the left.
+static void quotient_step(hgcd_matrix& m, umodpoly& c, umodpoly& d)
+{
+	umodpoly q, r;
+	poly_divide(q, r, c, d);
+	umodpoly n0 = poly_sub(m.m00, poly_mul(q, m.m10));
+	umodpoly n1 = poly_sub(m.m01, poly_mul(q, m.m11));
+	m.m00.swap(m.m10);
+	m.m01.swap(m.m11);
+	m.m10.swap(n0);
+	m.m11.swap(n1);
+	c.swap(d);
+	d.swap(r);
+}
+
+// Matrix of the quotient steps of the remainder sequence of a and b,
+// deg(a) > deg(b), up to the first remainder of degree below
+// k = ceil(deg(a)/2): (c, d) = m (a, b) with deg(c) >= k > deg(d).
+// The upper halves of a and b determine the first half of the quotients,
+// which are found recursively from them.
+static hgcd_matrix hgcd(const umodpoly& a, const umodpoly& b)
+{
+	const std::size_t n = degree(a);
+	const std::size_t k = (n + 1)/2;
+	hgcd_matrix m = identity_matrix(lcoeff(a));
+	if (b.empty() || degree(b) < k)
+		return m;
+
+	if (n < hgcd_base_degree) {
+		umodpoly c = a, d = b;
+		while (!d.empty() && degree(d) >= k)
+			quotient_step(m, c, d);
+		return m;
+	}
+
+	m = hgcd(shift_down(a, k), shift_down(b, k));
+	umodpoly c, d;
+	apply(c, d, m, a, b);
+	if (d.empty() || degree(d) < k)
+		return m;
+	quotient_step(m, c, d);
+	if (d.empty() || degree(d) < k)
+		return m;
+	bug_on(degree(c) > 2*k, "half-GCD: degree(c) = " << degree(c) <<
+	                        " is too large, k = " << k);
+	const std::size_t l = 2*k - degree(c);
+	return hgcd(shift_down(c, l), shift_down(d, l))*m;
+}
+
+void half_gcd(umodpoly& g, const umodpoly& a, const umodpoly& b)
+{
+	umodpoly c = a, d = b;
+	if (c.size() < d.size())
+		c.swap(d);
+	while (!d.empty()) {
+		if (degree(d) >= hgcd_base_degree && degree(c) > degree(d)) {
+			const hgcd_matrix m = hgcd(c, d);
+			umodpoly c1, d1;
+			apply(c1, d1, m, c, d);
+			c.swap(c1);
+			d.swap(d1);
+			if (d.empty())
+				break;
+		}
+		umodpoly r;
+		remainder_in_field(r, c, d);
+		c.swap(d);
+		d.swap(r);
+	}
+	normalize_in_field(c);
+	g.swap(c);
+}
+
+} // namespace GiNaC
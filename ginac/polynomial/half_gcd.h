@@ -0,0 +1,48 @@
+/** @file half_gcd.h
+ *
+ *  GCD of univariate polynomials over Z_p by the half-GCD algorithm. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_HALF_GCD_H
+#define GINAC_HALF_GCD_H
+
+#include "upoly.h"
+
+namespace GiNaC {
+
+/// Degree of the smaller input from which on gcd_euclid() switches to
+/// half_gcd() (see check/time_uvar_gcd.cpp for the crossover).
+const std::size_t half_gcd_threshold = 160;
+
+/**
+ * GCD of univariate polynomials a, b over Z_p, normalized to be monic.
+ *
+ * The half-GCD step computes the product of the quotient matrices of the
+ * first half of the Euclidean remainder sequence from the upper halves of
+ * the coefficients only, so the degrees are halved with a constant number
+ * of polynomial multiplications. With Karatsuba multiplication this takes
+ * O(n^1.59 log n) operations instead of the O(n^2) of the Euclidean
+ * algorithm.
+ */
+extern void half_gcd(umodpoly& g, const umodpoly& a, const umodpoly& b);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_HALF_GCD_H
@@ -58,7 +58,7 @@ static cln::cl_I extract_integer_content(ex& Apr, const ex& A)
 	}
 }
 
-ex chinrem_gcd(const ex& A_, const ex& B_, const exvector& vars)
+ex chinrem_gcd(const ex& A_, const ex& B_, const exvector& vars, bool sparse)
 {
 	ex A, B;
 	const cln::cl_I a_icont = extract_integer_content(A, A_);
@@ -91,7 +91,7 @@ ex chinrem_gcd(const ex& A_, const ex& B_, const exvector& vars)
 		const numeric pnum(p);
 		ex Ap = A.smod(pnum);
 		ex Bp = B.smod(pnum);
-		ex Cp = pgcd(Ap, Bp, vars, p);
+		ex Cp = sparse ? sparse_pgcd(Ap, Bp, vars, p) : pgcd(Ap, Bp, vars, p);
 
 		const cln::cl_I g_lcp = smod(g_lc, p); 
 		const cln::cl_I Cp_lc = integer_lcoeff(Cp, vars);
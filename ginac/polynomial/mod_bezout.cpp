@@ -0,0 +1,123 @@
+/** @file mod_bezout.cpp
+ *
+ *  Bezout cofactors of univariate integer polynomials by modular methods. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "mod_bezout.h"
+#include "multipoint.h"
+#include "primes_factory.h"
+#include "smod_helpers.h"
+#include "debug.h"
+
+#include <cln/integer.h>
+#include <cln/modinteger.h>
+#include <cln/rational.h>
+#include <stdexcept>
+
+namespace GiNaC {
+
+/// Number of consecutive primes modulo which a and b have a common factor
+/// after which they are taken to be not coprime over Q.
+static const int max_unlucky_primes = 16;
+
+// s with s a = 1 (mod b) over Z_p, false if gcd(a, b) != 1 modulo p
+static bool bezout_in_z_p(umodpoly& s, const umodpoly& a, const umodpoly& b)
+{
+	// invariant: s_i a = r_i (mod b)
+	umodpoly q, r0 = b, r1, s0, s1(1, the_one(lcoeff(b)));
+	poly_divide(q, r1, a, b);
+	while (r1.size() > 1) {
+		umodpoly r2;
+		poly_divide(q, r2, r0, r1);
+		umodpoly s2 = poly_sub(s0, poly_mul(q, s1));
+		r0.swap(r1);
+		r1.swap(r2);
+		s0.swap(s1);
+		s1.swap(s2);
+	}
+	if (r1.empty())
+		return false;
+	const cln::cl_MI inv = recip(r1[0]);
+	for (std::size_t i = 0; i < s1.size(); ++i)
+		s1[i] = s1[i]*inv;
+	s.swap(s1);
+	return true;
+}
+
+bool mod_bezout(std::vector<cln::cl_N>& s, const upoly& a, const upoly& b)
+{
+	bug_on(b.size() < 2, "mod_bezout: b must have positive degree");
+	const std::size_t n = b.size() - 1;
+	const std::vector<cln::cl_N> aq(a.begin(), a.end()), bq(b.begin(), b.end());
+	const std::vector<cln::cl_N> one(1, cln::cl_N(1));
+
+	primes_factory pfactory;
+	std::vector<cln::cl_I> acc(n, cln::cl_I(0));
+	cln::cl_I q = 0;
+	int unlucky = 0;
+	long p;
+	while (pfactory(p, lcoeff(a)*lcoeff(b))) {
+		const cln::cl_modint_ring R = cln::find_modint_ring(cln::cl_I(p));
+		umodpoly ap(a.size(), R->zero()), bp(b.size(), R->zero()), sp;
+		make_umodpoly(ap, a, R);
+		make_umodpoly(bp, b, R);
+		if (!bezout_in_z_p(sp, ap, bp)) {
+			if (++unlucky == max_unlucky_primes)
+				return false;
+			continue;
+		}
+		unlucky = 0;
+
+		if (zerop(q)) {
+			for (std::size_t i = 0; i < sp.size(); ++i)
+				acc[i] = R->retract(sp[i]);
+			q = p;
+		} else {
+			const cln::cl_I qinv = recip(cln::mod(q, p), p);
+			for (std::size_t i = 0; i < n; ++i) {
+				const cln::cl_I si = i < sp.size() ? R->retract(sp[i]) : cln::cl_I(0);
+				acc[i] = acc[i] + q*cln::mod((si - acc[i])*qinv, p);
+			}
+			q = q*p;
+		}
+
+		std::vector<cln::cl_N> cand(n);
+		bool ok = true;
+		for (std::size_t i = 0; ok && i < n; ++i) {
+			cln::cl_RA c = 0;
+			ok = rational_reconstruction(c, acc[i], q);
+			cand[i] = c;
+		}
+		if (!ok)
+			continue;
+		canonicalize(cand);
+
+		// s a - 1 must be divisible by b
+		std::vector<cln::cl_N> quot, rem;
+		poly_divide(quot, rem, poly_sub(poly_mul(cand, aq), one), bq);
+		if (rem.empty()) {
+			s.swap(cand);
+			return true;
+		}
+	}
+	throw std::runtime_error("mod_bezout: ran out of primes");
+}
+
+} // namespace GiNaC
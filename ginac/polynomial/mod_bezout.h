@@ -0,0 +1,49 @@
+/** @file mod_bezout.h
+ *
+ *  Bezout cofactors of univariate integer polynomials by modular methods. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_MOD_BEZOUT_H
+#define GINAC_MOD_BEZOUT_H
+
+#include "upoly.h"
+
+#include <cln/number.h>
+#include <vector>
+
+namespace GiNaC {
+
+/**
+ * Cofactor @a s with s a = 1 (mod b) and deg(s) < deg(b) for coprime
+ * a, b in Z[x] with deg(b) > 0, the coefficients of s being rational.
+ *
+ * The extended Euclidean algorithm runs over Z_p for several primes, the
+ * images are combined by Chinese remaindering and the coefficients are
+ * recovered by rational number reconstruction until the candidate is
+ * verified over Q.  This avoids the growth of the coefficients in the
+ * remainder sequence over Q.
+ *
+ * @return false if a and b are not coprime.
+ */
+extern bool mod_bezout(std::vector<cln::cl_N>& s, const upoly& a, const upoly& b);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_MOD_BEZOUT_H
@@ -0,0 +1,271 @@
+/** @file multipoint.h
+ *
+ *  Evaluation of univariate polynomials at many points and interpolation
+ *  from many points using a subproduct tree. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_MULTIPOINT_H
+#define GINAC_MULTIPOINT_H
+
+#include "upoly.h"
+#include "ring_traits.h"
+#include "debug.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace GiNaC {
+
+/// Below this number of coefficients of the shorter factor poly_mul()
+/// multiplies by the schoolbook method.
+static const std::size_t karatsuba_threshold = 32;
+
+template<typename T> static T poly_add(const T& a, const T& b);
+template<typename T> static T poly_sub(const T& a, const T& b);
+
+/// Product of two univariate polynomials.  Long factors are split in halves
+/// and multiplied with three half-size products (Karatsuba).
+template<typename T> static T poly_mul(const T& a, const T& b)
+{
+	if (a.empty() || b.empty())
+		return T();
+	const typename T::value_type zero = get_ring_elt(a[0], 0);
+	T c(a.size() + b.size() - 1, zero);
+	if (std::min(a.size(), b.size()) < karatsuba_threshold) {
+		for (std::size_t i = 0; i < a.size(); ++i) {
+			if (zerop(a[i]))
+				continue;
+			for (std::size_t j = 0; j < b.size(); ++j)
+				c[i + j] = c[i + j] + a[i]*b[j];
+		}
+		canonicalize(c);
+		return c;
+	}
+
+	// a = a0 + x^h a1, b = b0 + x^h b1
+	const std::size_t h = std::max(a.size(), b.size())/2;
+	T a0(a.begin(), a.begin() + std::min(h, a.size()));
+	T b0(b.begin(), b.begin() + std::min(h, b.size()));
+	T a1, b1;
+	if (a.size() > h)
+		a1.assign(a.begin() + h, a.end());
+	if (b.size() > h)
+		b1.assign(b.begin() + h, b.end());
+	canonicalize(a0);
+	canonicalize(b0);
+	const T z0 = poly_mul(a0, b0);
+	const T z2 = poly_mul(a1, b1);
+	const T z1 = poly_sub(poly_sub(poly_mul(poly_add(a0, a1), poly_add(b0, b1)), z0), z2);
+	for (std::size_t i = 0; i < z0.size(); ++i)
+		c[i] = c[i] + z0[i];
+	// the top coefficients of z1 cancel, except for rounding errors
+	for (std::size_t i = 0; i < z1.size() && i + h < c.size(); ++i)
+		c[i + h] = c[i + h] + z1[i];
+	for (std::size_t i = 0; i < z2.size(); ++i)
+		c[i + 2*h] = c[i + 2*h] + z2[i];
+	canonicalize(c);
+	return c;
+}
+
+/// Sum of two univariate polynomials.
+template<typename T> static T poly_add(const T& a, const T& b)
+{
+	const T& l = a.size() < b.size() ? b : a;
+	const T& s = a.size() < b.size() ? a : b;
+	T c(l);
+	for (std::size_t i = 0; i < s.size(); ++i)
+		c[i] = c[i] + s[i];
+	canonicalize(c);
+	return c;
+}
+
+/// Difference of two univariate polynomials.
+template<typename T> static T poly_sub(const T& a, const T& b)
+{
+	T c(a);
+	if (c.size() < b.size())
+		c.resize(b.size(), get_ring_elt(b[0], 0));
+	for (std::size_t i = 0; i < b.size(); ++i)
+		c[i] = c[i] - b[i];
+	canonicalize(c);
+	return c;
+}
+
+/// Derivative of a univariate polynomial.
+template<typename T> static T poly_derivative(const T& p)
+{
+	if (p.size() < 2)
+		return T();
+	T d(p.size() - 1, p[0]);
+	for (std::size_t i = 1; i < p.size(); ++i)
+		d[i - 1] = get_ring_elt(p[i], i)*p[i];
+	canonicalize(d);
+	return d;
+}
+
+/// Remainder of @a a modulo the monic polynomial @a m.  Only ring
+/// operations are needed, so this works over Z as well as over fields.
+template<typename T> static T rem_monic(const T& a, const T& m)
+{
+	bug_on(m.empty(), "division by zero polynomial");
+	const std::size_t n = m.size() - 1;
+	if (a.size() <= n)
+		return a;
+	T r(a);
+	for (std::size_t k = r.size(); k-- > n; ) {
+		const typename T::value_type c = r[k];
+		if (zerop(c))
+			continue;
+		for (std::size_t i = 0; i < n; ++i)
+			r[k - n + i] = r[k - n + i] - c*m[i];
+	}
+	r.resize(n);
+	canonicalize(r);
+	return r;
+}
+
+/// Quotient @a q and remainder @a r of @a a and @a b != 0.  The
+/// coefficients must form a field.
+template<typename T> static void poly_divide(T& q, T& r, const T& a, const T& b)
+{
+	bug_on(b.empty(), "division by zero polynomial");
+	r = a;
+	if (a.size() < b.size()) {
+		q.clear();
+		return;
+	}
+	const typename T::value_type inv = div(the_one(lcoeff(b)), lcoeff(b));
+	const std::size_t n = b.size() - 1;
+	q.assign(a.size() - n, get_ring_elt(inv, 0));
+	for (std::size_t k = a.size(); k-- > n; ) {
+		if (zerop(r[k]))
+			continue;
+		const typename T::value_type qk = r[k]*inv;
+		q[k - n] = qk;
+		for (std::size_t i = 0; i <= n; ++i)
+			r[k - n + i] = r[k - n + i] - qk*b[i];
+	}
+	r.resize(n);
+	canonicalize(r);
+	canonicalize(q);
+}
+
+/**
+ * Subproduct tree of the points u_0, ..., u_{n-1}.
+ *
+ * The leaves are the linear polynomials x - u_i, every inner node is the
+ * product of its two children (an odd node at the end of a level is
+ * carried up unchanged), and the root is the product of all x - u_i.
+ * Evaluating a polynomial at all points then amounts to reducing it
+ * modulo the nodes on the way down from the root, and interpolation to
+ * combining the Lagrange terms on the way up, which replaces the n
+ * independent Horner evaluations and the quadratic Newton scheme by
+ * O(log n) levels of polynomial arithmetic.
+ */
+template<typename T> class subproduct_tree
+{
+public:
+	typedef typename T::value_type ring_t;
+
+	explicit subproduct_tree(const std::vector<ring_t>& pts)
+		: zero(get_ring_elt(pts.at(0), 0))
+	{
+		std::vector<T> leaves;
+		leaves.reserve(pts.size());
+		for (auto & u : pts)
+			leaves.push_back(T{-u, the_one(u)});
+		levels.push_back(leaves);
+		while (levels.back().size() > 1) {
+			const std::vector<T>& prev = levels.back();
+			std::vector<T> next;
+			next.reserve((prev.size() + 1)/2);
+			for (std::size_t i = 0; i + 1 < prev.size(); i += 2)
+				next.push_back(poly_mul(prev[i], prev[i + 1]));
+			if (prev.size() % 2)
+				next.push_back(prev.back());
+			levels.push_back(next);
+		}
+	}
+
+	/// Number of points.
+	std::size_t size() const { return levels[0].size(); }
+
+	/// Product of x - u_i over all points.
+	const T& root() const { return levels.back()[0]; }
+
+	/// Values of the polynomial @a p at all points.
+	std::vector<ring_t> evaluate(const T& p) const
+	{
+		std::vector<T> rems(1, rem_monic(p, root()));
+		for (std::size_t k = levels.size() - 1; k-- != 0; ) {
+			const std::vector<T>& level = levels[k];
+			std::vector<T> next(level.size());
+			for (std::size_t i = 0; i < level.size(); ++i)
+				next[i] = rem_monic(rems[i/2], level[i]);
+			rems.swap(next);
+		}
+		std::vector<ring_t> values;
+		values.reserve(rems.size());
+		for (auto & r : rems)
+			values.push_back(r.empty() ? zero : r[0]);
+		return values;
+	}
+
+	/// The polynomial of degree less than size() taking the given values
+	/// at the points.  The coefficients must form a field.
+	/// @exception invalid_argument (the points are not distinct)
+	T interpolate(const std::vector<ring_t>& values) const
+	{
+		bug_on(values.size() != size(), "wrong number of values");
+		// Lagrange weights 1/prod_{j != i} (u_i - u_j) are the reciprocal
+		// values of the derivative of the root
+		const std::vector<ring_t> w = evaluate(poly_derivative(root()));
+		std::vector<T> terms;
+		terms.reserve(size());
+		for (std::size_t i = 0; i < size(); ++i) {
+			if (zerop(w[i]))
+				throw std::invalid_argument("interpolation points are not distinct");
+			T c(1, div(values[i], w[i]));
+			canonicalize(c);
+			terms.push_back(c);
+		}
+		for (std::size_t k = 0; k + 1 < levels.size(); ++k) {
+			const std::vector<T>& level = levels[k];
+			std::vector<T> next;
+			next.reserve((level.size() + 1)/2);
+			for (std::size_t i = 0; i + 1 < level.size(); i += 2)
+				next.push_back(poly_add(poly_mul(terms[i], level[i + 1]),
+				                        poly_mul(terms[i + 1], level[i])));
+			if (level.size() % 2)
+				next.push_back(terms.back());
+			terms.swap(next);
+		}
+		return terms[0];
+	}
+
+private:
+	ring_t zero;
+	std::vector<std::vector<T>> levels;
+};
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_MULTIPOINT_H
@@ -27,18 +27,245 @@
 #include "eval_point_finder.h"
 #include "newton_interpolate.h"
 #include "divide_in_z_p.h"
+#include "add.h"
+#include "mul.h"
+#include "upoly.h"
+#include "multipoint.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace GiNaC {
 
 extern void
 primpart_content(ex& pp, ex& c, ex e, const exvector& vars, const long p);
 
+typedef std::vector<std::vector<cln::cl_MI>> modmatrix;
+
+// Solve the linear system given by the augmented matrix m (the last column
+// holds the right hand side) over Z_p by Gaussian elimination. Returns false
+// if the system is inconsistent or its solution is not unique.
+static bool solve_mod_p(std::vector<cln::cl_MI>& x, modmatrix& m,
+			const std::size_t ncols)
+{
+	const std::size_t nrows = m.size();
+	std::size_t row = 0;
+	for (std::size_t col = 0; col < ncols; ++col) {
+		std::size_t piv = row;
+		while (piv < nrows && zerop(m[piv][col]))
+			++piv;
+		if (piv == nrows)
+			return false;
+		std::swap(m[row], m[piv]);
+		const cln::cl_MI inv = cln::recip(m[row][col]);
+		for (std::size_t j = col; j <= ncols; ++j)
+			m[row][j] = m[row][j]*inv;
+		for (std::size_t i = 0; i < nrows; ++i) {
+			if (i == row || zerop(m[i][col]))
+				continue;
+			const cln::cl_MI f = m[i][col];
+			for (std::size_t j = col; j <= ncols; ++j)
+				m[i][j] = m[i][j] - f*m[row][j];
+		}
+		++row;
+	}
+	for (std::size_t i = row; i < nrows; ++i) {
+		if (!zerop(m[i][ncols]))
+			return false;
+	}
+	x.resize(ncols);
+	for (std::size_t i = 0; i < ncols; ++i)
+		x[i] = m[i][ncols];
+	return true;
+}
+
+// Image of a polynomial in Z_p[x_0, \ldots, x_n], given by its terms, in
+// Z_p[x_0] with x_1, \ldots, x_n evaluated at alpha[1], \ldots, alpha[n]
+static void eval_rest(umodpoly& u, const ex_collect_t& e,
+		      const std::vector<cln::cl_MI>& alpha,
+		      const cln::cl_modint_ring& R)
+{
+	u.clear();
+	for (auto & t : e) {
+		cln::cl_MI c = R->canonhom(to_cl_I(t.second));
+		for (std::size_t i = 1; i < alpha.size(); ++i) {
+			if (t.first[i] != 0)
+				c = c*cln::expt_pos(alpha[i], t.first[i]);
+		}
+		const std::size_t d = t.first[0];
+		if (u.size() <= d)
+			u.resize(d + 1, R->zero());
+		u[d] = u[d] + c;
+	}
+	canonicalize(u);
+}
+
+static int degree_in_first(const ex_collect_t& e)
+{
+	int d = 0;
+	for (auto & t : e)
+		d = std::max(d, t.first[0]);
+	return d;
+}
+
+// Images of A \in Z_p[x_0, \ldots, x_{n-1}][x_n] at x_n = pts[i] for all
+// points at once. Every coefficient of A (a univariate polynomial in x_n)
+// is evaluated at all points by one walk down the subproduct tree of the
+// points instead of substituting each point into A separately.
+static exvector eval_main_var(const ex& A, const exvector& vars,
+			      const std::vector<long>& pts, const long p)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(p);
+	const std::size_t n = vars.size() - 1;
+	ex_collect_t ca;
+	collect_vargs(ca, A, vars);
+	std::map<exp_vector_t, umodpoly> coeffs;
+	for (auto & t : ca) {
+		umodpoly& u = coeffs[exp_vector_t(t.first.begin(), t.first.begin() + n)];
+		const std::size_t d = t.first[n];
+		if (u.size() <= d)
+			u.resize(d + 1, R->zero());
+		u[d] = u[d] + R->canonhom(to_cl_I(t.second));
+	}
+
+	std::vector<cln::cl_MI> upts;
+	upts.reserve(pts.size());
+	for (auto & b : pts)
+		upts.push_back(R->canonhom(b));
+	const subproduct_tree<umodpoly> tree(upts);
+
+	std::vector<exvector> terms(pts.size());
+	for (auto & c : coeffs) {
+		canonicalize(c.second);
+		if (c.second.empty())
+			continue;
+		const std::vector<cln::cl_MI> vals = tree.evaluate(c.second);
+		exvector mv;
+		mv.reserve(n);
+		for (std::size_t j = 0; j < n; ++j) {
+			if (c.first[j] != 0)
+				mv.push_back(pow(vars[j], c.first[j]));
+		}
+		const ex m = dynallocate<mul>(mv);
+		for (std::size_t i = 0; i < pts.size(); ++i) {
+			if (!zerop(vals[i]))
+				terms[i].push_back(m*numeric(smod(R->retract(vals[i]), p)));
+		}
+	}
+	exvector images;
+	images.reserve(pts.size());
+	for (auto & t : terms)
+		images.push_back(dynallocate<add>(t));
+	return images;
+}
+
+// Zippel's sparse interpolation: compute the GCD of A, B \in Z_p[vars]
+// assuming it consists of the same monomials as the previously computed
+// image skel. The coefficients are found from univariate GCDs in vars[0]
+// at random points, one unknown scaling factor per univariate image.
+// Returns false if the assumption turns out to be wrong or the linear
+// system is degenerate; the caller has to compute the image densely then.
+static bool sparse_image(ex& G, const ex& A, const ex& B, const ex& skel,
+			 const exvector& vars, const long p)
+{
+	const cln::cl_modint_ring R = cln::find_modint_ring(p);
+	ex_collect_t ca, cb, cs;
+	collect_vargs(ca, A, vars);
+	collect_vargs(cb, B, vars);
+	collect_vargs(cs, skel, vars);
+	if (ca.empty() || cb.empty() || cs.empty())
+		return false;
+
+	// Columns of the unknown coefficients, grouped by the degree in vars[0]
+	const int D = degree_in_first(cs);
+	if (D == 0)
+		return false;
+	std::vector<std::vector<std::size_t>> support(D + 1);
+	std::size_t maxsupp = 0;
+	for (std::size_t i = 0; i < cs.size(); ++i) {
+		support[cs[i].first[0]].push_back(i);
+		maxsupp = std::max(maxsupp, support[cs[i].first[0]].size());
+	}
+	const std::size_t N = cs.size();
+	const std::size_t nimages = std::max(maxsupp, (N + D - 1)/D) + 1;
+	const std::size_t ncols = N + nimages - 1;
+
+	const int dega = degree_in_first(ca);
+	const int degb = degree_in_first(cb);
+	const random_modint gen(p);
+	modmatrix m;
+	m.reserve(nimages*(D + 1));
+	std::vector<cln::cl_MI> alpha(vars.size(), R->zero());
+	std::size_t found = 0, tries = 0;
+	while (found < nimages) {
+		if (++tries > 3*nimages + 10)
+			return false;
+		for (std::size_t i = 1; i < vars.size(); ++i)
+			alpha[i] = R->canonhom(gen());
+		umodpoly ua, ub, g;
+		eval_rest(ua, ca, alpha, R);
+		eval_rest(ub, cb, alpha, R);
+		// the leading coefficient vanishes at this point
+		if (ua.empty() || ub.empty() || int(degree(ua)) != dega || int(degree(ub)) != degb)
+			continue;
+		gcd_euclid(g, ua, ub);
+		// unlucky evaluation point
+		if (int(degree(g)) > D)
+			continue;
+		// the skeleton was obtained from an unlucky image
+		if (int(degree(g)) < D)
+			return false;
+
+		for (int d = 0; d <= D; ++d) {
+			std::vector<cln::cl_MI> row(ncols + 1, R->zero());
+			for (auto & i : support[d]) {
+				cln::cl_MI mv = R->one();
+				for (std::size_t j = 1; j < vars.size(); ++j) {
+					if (cs[i].first[j] != 0)
+						mv = mv*cln::expt_pos(alpha[j], cs[i].first[j]);
+				}
+				row[i] = mv;
+			}
+			// the first image fixes the overall scaling
+			if (found == 0)
+				row[ncols] = g[d];
+			else
+				row[N + found - 1] = -g[d];
+			m.push_back(row);
+		}
+		++found;
+	}
+
+	std::vector<cln::cl_MI> x;
+	if (!solve_mod_p(x, m, ncols))
+		return false;
+
+	exvector terms;
+	terms.reserve(N);
+	for (std::size_t i = 0; i < N; ++i) {
+		if (zerop(x[i]))
+			return false;
+		exvector tv;
+		tv.reserve(vars.size() + 1);
+		tv.push_back(numeric(smod(R->retract(x[i]), p)));
+		for (std::size_t j = 0; j < vars.size(); ++j)
+			tv.push_back(pow(vars[j], cs[i].first[j]));
+		terms.push_back(dynallocate<mul>(tv));
+	}
+	G = dynallocate<add>(terms);
+	return true;
+}
+
 // Computes the GCD of two polynomials over a prime field.
 // Based on Algorithm 7.2 from "Algorithms for Computer Algebra"
 // A and B are considered as Z_p[x_n][x_0, \ldots, x_{n-1}], that is,
 // as a polynomials in variables x_0, \ldots x_{n-1} having coefficients
 // from the ring Z_p[x_n]
-ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
+// If sparse is true, all but the first image in Z_p[x_0, \ldots, x_{n-1}]
+// are computed by sparse interpolation (see sparse_image()).
+static ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p,
+	       const bool sparse)
 {
 	static const ex ex1(1);
 	if (A.is_zero())
@@ -86,18 +313,44 @@ ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
 
 	eval_point_finder find_eval_point(p);
 	const numeric pn(p);
+	// Enough points to interpolate the GCD times a factor of the leading
+	// coefficient; sparse images are trusted only that far
+	const int max_points = std::min(Aprim.degree(mainvar), Bprim.degree(mainvar)) +
+			       lc_gcd.degree(mainvar) + 1;
+	int npoints = 0;
+	ex skel; // last image, its monomials are used for sparse interpolation
+	// Evaluation points are found in batches of growing size, and A and B
+	// are evaluated at a whole batch at once
+	std::vector<long> batch;
+	exvector Abatch, Bbatch;
+	std::size_t next_pt = 0;
+	std::size_t batch_size = std::min(4, max_points);
 	do {
-		// Find a `good' evaluation point b.
-		bool has_more_pts = find_eval_point(b, lc_gcd, mainvar);
-		// If there are no more possible evaluation points, bail out
-		if (!has_more_pts)
+		if (sparse && ++npoints > max_points)
 			throw pgcd_failed();
-
+		if (next_pt == batch.size()) {
+			batch.clear();
+			// Find `good' evaluation points.
+			while (batch.size() < batch_size &&
+			       find_eval_point(b, lc_gcd, mainvar))
+				batch.push_back(b);
+			// If there are no more possible evaluation points, bail out
+			if (batch.empty())
+				throw pgcd_failed();
+			Abatch = eval_main_var(Aprim, vars, batch, p);
+			Bbatch = eval_main_var(Bprim, vars, batch, p);
+			next_pt = 0;
+			batch_size = std::min<std::size_t>(2*batch_size, max_points);
+		}
+		b = batch[next_pt];
 		const numeric bn(b);
-		// Evaluate the polynomials in b
-		ex Ab = Aprim.subs(mainvar == bn).smod(pn);
-		ex Bb = Bprim.subs(mainvar == bn).smod(pn);
-		ex Cb = pgcd(Ab, Bb, restvars, p);
+		const ex& Ab = Abatch[next_pt];
+		const ex& Bb = Bbatch[next_pt];
+		++next_pt;
+		ex Cb;
+		if (!sparse || skel.is_zero() || restvars.size() < 2 ||
+		    !sparse_image(Cb, Ab, Bb, skel, restvars, p))
+			Cb = pgcd(Ab, Bb, restvars, p, sparse);
 
 		// Set the correct the leading coefficient
 		const cln::cl_I lcb_gcd =
@@ -115,9 +368,11 @@ ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
 			// The degree decreased, previous homomorphisms were
 			// bad, so we have to start it all over.
 			H = Cb;
+			skel = Cb;
 			newton_poly = mainvar - numeric(b);
 			Hprev = 0;
 			gcd_deg  = img_gcd_deg;
+			npoints = 1;
 			continue;
 		} 
 		if (img_gcd_deg > gcd_deg) {
@@ -129,6 +384,7 @@ ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
 		// Image has the same degree as the previous one
 		// (or at least not higher than the limit)
 		Hprev = H;
+		skel = Cb;
 		H = newton_interp(Cb, b, H, newton_poly, mainvar, p);
 		newton_poly = newton_poly*(mainvar - b);
 
@@ -153,4 +409,14 @@ ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
 	throw pgcd_failed();
 }
 
+ex pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
+{
+	return pgcd(A, B, vars, p, false);
+}
+
+ex sparse_pgcd(const ex& A, const ex& B, const exvector& vars, const long p)
+{
+	return pgcd(A, B, vars, p, true);
+}
+
 } // namespace GiNaC
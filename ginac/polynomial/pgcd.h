@@ -44,6 +44,18 @@ struct pgcd_failed
 extern ex
 pgcd(const ex& A, const ex& B, const exvector& vars, const long p);
 
+/**
+ * @brief Compute the GCD of two polynomials over a prime field Z_p using
+ * Zippel's sparse interpolation
+ *
+ * Like pgcd(), but only the first image of the GCD is computed recursively;
+ * the others are obtained by sparse interpolation assuming they consist of
+ * the same monomials. Suitable for sparse polynomials in many variables.
+ * Throws pgcd_failed if that assumption leads nowhere.
+ */
+extern ex
+sparse_pgcd(const ex& A, const ex& B, const exvector& vars, const long p);
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_CHINREM_GCD_PGCD_H
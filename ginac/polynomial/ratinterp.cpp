@@ -0,0 +1,776 @@
+/** @file ratinterp.cpp
+ *
+ *  Normal form of rational functions by evaluation and sparse rational
+ *  interpolation modulo primes. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ratinterp.h"
+#include "collect_vargs.h"
+#include "multipoint.h"
+#include "primes_factory.h"
+#include "smod_helpers.h"
+#include "add.h"
+#include "mul.h"
+#include "numeric.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <cln/integer.h>
+#include <cln/modinteger.h>
+#include <cln/rational.h>
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace GiNaC {
+
+typedef std::vector<cln::cl_MI> modvector;
+typedef std::vector<std::pair<exp_vector_t, cln::cl_MI>> modterms;
+
+/// Thrown when random evaluation points or shifts turn out to be
+/// degenerate; the image has to be computed with new random choices.
+struct unlucky_choice
+{
+	virtual ~unlucky_choice() { }
+};
+
+/// Straight-line program computing the value of a rational expression
+/// modulo a prime.  Common subexpressions are evaluated only once.
+class modular_evaluator
+{
+public:
+	modular_evaluator(const ex& e, const exvector& vars);
+
+	/// Switch to the prime field R.  Returns false if the denominator of
+	/// some coefficient vanishes in R.
+	bool set_ring(const cln::cl_modint_ring& R_);
+
+	/// Value @a v at the point @a x, false on a division by zero.
+	bool operator()(cln::cl_MI& v, const modvector& x) const;
+
+private:
+	enum opcode { op_const, op_var, op_add, op_mul, op_pow };
+	struct instruction
+	{
+		opcode op;
+		/// constant or variable index, or the exponent
+		long arg;
+		std::vector<std::size_t> args;
+	};
+
+	std::size_t compile(const ex& e);
+
+	std::map<ex, std::size_t, ex_is_less> var_index;
+	std::map<ex, std::size_t, ex_is_less> slots;
+	std::vector<instruction> code;
+	std::vector<cln::cl_RA> constants;
+	modvector modconstants;
+	cln::cl_modint_ring R;
+};
+
+modular_evaluator::modular_evaluator(const ex& e, const exvector& vars)
+{
+	for (std::size_t i = 0; i < vars.size(); ++i)
+		var_index[vars[i]] = i;
+	compile(e);
+}
+
+std::size_t modular_evaluator::compile(const ex& e)
+{
+	auto found = slots.find(e);
+	if (found != slots.end())
+		return found->second;
+
+	instruction in;
+	in.arg = 0;
+	if (is_exactly_a<numeric>(e)) {
+		if (!e.info(info_flags::rational))
+			throw std::invalid_argument("ratinterp_normal(): coefficients must be rational");
+		in.op = op_const;
+		in.arg = constants.size();
+		constants.push_back(cln::the<cln::cl_RA>(ex_to<numeric>(e).to_cl_N()));
+	} else if (is_a<symbol>(e)) {
+		auto v = var_index.find(e);
+		if (v == var_index.end())
+			throw std::invalid_argument("ratinterp_normal(): unexpected symbol");
+		in.op = op_var;
+		in.arg = v->second;
+	} else if (is_exactly_a<add>(e) || is_exactly_a<mul>(e)) {
+		in.op = is_exactly_a<add>(e) ? op_add : op_mul;
+		in.args.reserve(e.nops());
+		for (std::size_t i = 0; i < e.nops(); ++i)
+			in.args.push_back(compile(e.op(i)));
+	} else if (is_exactly_a<power>(e) && e.op(1).info(info_flags::integer)) {
+		in.op = op_pow;
+		in.arg = ex_to<numeric>(e.op(1)).to_long();
+		in.args.push_back(compile(e.op(0)));
+	} else
+		throw std::invalid_argument("ratinterp_normal(): argument must be a rational function");
+
+	code.push_back(in);
+	slots[e] = code.size() - 1;
+	return code.size() - 1;
+}
+
+bool modular_evaluator::set_ring(const cln::cl_modint_ring& R_)
+{
+	R = R_;
+	modconstants.clear();
+	modconstants.reserve(constants.size());
+	for (auto & c : constants) {
+		const cln::cl_MI d = R->canonhom(cln::denominator(c));
+		if (zerop(d))
+			return false;
+		modconstants.push_back(R->canonhom(cln::numerator(c))*cln::recip(d));
+	}
+	return true;
+}
+
+bool modular_evaluator::operator()(cln::cl_MI& v, const modvector& x) const
+{
+	modvector val(code.size(), R->zero());
+	for (std::size_t i = 0; i < code.size(); ++i) {
+		const instruction& in = code[i];
+		switch (in.op) {
+		case op_const:
+			val[i] = modconstants[in.arg];
+			break;
+		case op_var:
+			val[i] = x[in.arg];
+			break;
+		case op_add: {
+			cln::cl_MI s = R->zero();
+			for (auto & a : in.args)
+				s = s + val[a];
+			val[i] = s;
+			break;
+		}
+		case op_mul: {
+			cln::cl_MI s = R->one();
+			for (auto & a : in.args)
+				s = s*val[a];
+			val[i] = s;
+			break;
+		}
+		case op_pow: {
+			cln::cl_MI b = val[in.args[0]];
+			if (in.arg < 0) {
+				if (zerop(b))
+					return false;
+				b = cln::recip(b);
+			}
+			val[i] = in.arg == 0 ? R->one() : cln::expt_pos(b, cln::cl_I(std::abs(in.arg)));
+			break;
+		}
+		}
+	}
+	v = val.back();
+	return true;
+}
+
+// Value of the univariate polynomial p at t (Horner rule)
+static cln::cl_MI poly_eval(const umodpoly& p, const cln::cl_MI& t)
+{
+	cln::cl_MI y = get_ring_elt(t, 0);
+	for (std::size_t i = p.size(); i-- != 0; )
+		y = y*t + p[i];
+	return y;
+}
+
+// Extended Euclidean algorithm on m and u, stopped at the first remainder r
+// of degree at most dn.  Then r = s u (mod m) with the cofactor s of u.
+static void poly_ratrecon(umodpoly& r, umodpoly& s, const umodpoly& m,
+			  const umodpoly& u, const int dn)
+{
+	umodpoly r0 = m, s0;
+	r = u;
+	s = umodpoly(1, the_one(m[0]));
+	while (!r.empty() && int(degree(r)) > dn) {
+		umodpoly q, rem;
+		poly_divide(q, rem, r0, r);
+		umodpoly snext = poly_sub(s0, poly_mul(q, s));
+		r0.swap(r);
+		r.swap(rem);
+		s0.swap(s);
+		s.swap(snext);
+	}
+}
+
+/// Image of the normal form numer/denom modulo one prime.
+///
+/// Along a line x = t y + s the function becomes a univariate rational
+/// function of t.  If D(s) != 0 and the denominator is normalized to
+/// D(s) = 1, the coefficient of t^k in N(t y + s) (and D(t y + s)) is a
+/// homogeneous polynomial of degree k in y (Cuyt and Lee).  Every line
+/// through s gives the values of all these coefficients at once, so they
+/// are interpolated as polynomials in y_1, ..., y_{n-1} with y_0 = 1 by
+/// Zippel's sparse interpolation, one variable after another.
+class modular_ratinterp
+{
+public:
+	modular_ratinterp(const modular_evaluator& f_, std::size_t n_, long p_)
+		: f(f_), n(n_), R(cln::find_modint_ring(p_)), gen(p_)
+	{ }
+
+	/// Numerator and denominator, with the coefficient of the last term of
+	/// the denominator (in the order of the map) normalized to one.
+	/// @exception unlucky_choice (degenerate random choices)
+	void image(std::map<exp_vector_t, cln::cl_I>& num,
+		   std::map<exp_vector_t, cln::cl_I>& den);
+
+private:
+	cln::cl_MI random_elt() const { return R->canonhom(gen()); }
+	modvector random_points(std::size_t k) const;
+	modvector sample_line(const modvector& tpts, const modvector& y) const;
+	void find_shift();
+	void find_degrees(const modvector& y);
+	modvector line_coeffs(const modvector& z) const;
+	void interpolate_coeffs(std::vector<modterms>& polys);
+	int degree_bound(std::size_t j) const
+	{
+		return int(j) <= dn ? int(j) : int(j) - dn;
+	}
+	void unshift(std::map<exp_vector_t, cln::cl_MI>& poly) const;
+
+	const modular_evaluator& f;
+	const std::size_t n;
+	const cln::cl_modint_ring R;
+	const random_modint gen;
+	modvector shift;
+	/// total degrees of numerator and denominator
+	int dn, dd;
+	modvector tpts;
+	std::unique_ptr<subproduct_tree<umodpoly>> ttree;
+};
+
+// k distinct random elements.  Fixed points like 0, 1, 2, ... would make
+// a pole of some subexpression at an integer hit every line through 0.
+modvector modular_ratinterp::random_points(std::size_t k) const
+{
+	modvector w;
+	w.reserve(k);
+	while (w.size() < k) {
+		const cln::cl_MI b = random_elt();
+		if (std::find(w.begin(), w.end(), b) == w.end())
+			w.push_back(b);
+	}
+	return w;
+}
+
+// Values of f(t y + s) for all points t
+modvector modular_ratinterp::sample_line(const modvector& ts, const modvector& y) const
+{
+	modvector x(n, R->zero()), vals;
+	vals.reserve(ts.size());
+	for (auto & t : ts) {
+		for (std::size_t i = 0; i < n; ++i)
+			x[i] = t*y[i] + shift[i];
+		cln::cl_MI v = R->zero();
+		if (!f(v, x))
+			throw unlucky_choice();
+		vals.push_back(v);
+	}
+	return vals;
+}
+
+// Find a point s where the program can be evaluated, so that D(s) != 0.
+// Shifts in more and more variables are tried to keep N(t y + s) sparse.
+void modular_ratinterp::find_shift()
+{
+	shift.assign(n, R->zero());
+	for (std::size_t k = 0; k <= n; ++k) {
+		if (k > 0)
+			shift[k - 1] = random_elt();
+		cln::cl_MI v = R->zero();
+		if (f(v, shift))
+			return;
+	}
+	throw unlucky_choice();
+}
+
+// Total degrees of numerator and denominator from the univariate function
+// t -> f(t y + s).  Rational reconstruction from L = 4, 8, 16, ... values
+// is tried until a candidate matches two further values.
+void modular_ratinterp::find_degrees(const modvector& y)
+{
+	for (std::size_t L = 4; ; L *= 2) {
+		const modvector ts = random_points(L + 2);
+		const modvector vals = sample_line(ts, y);
+		const subproduct_tree<umodpoly> tree(modvector(ts.begin(), ts.begin() + L));
+		umodpoly r0 = tree.root(), s0;
+		umodpoly r = tree.interpolate(modvector(vals.begin(), vals.begin() + L));
+		umodpoly s(1, R->one());
+		while (true) {
+			bool match = true;
+			for (std::size_t i = L; i < L + 2 && match; ++i)
+				match = poly_eval(r, ts[i]) == vals[i]*poly_eval(s, ts[i]);
+			if (match) {
+				if (zerop(s[0]))
+					throw unlucky_choice();
+				dn = r.empty() ? -1 : int(degree(r));
+				dd = int(degree(s));
+				return;
+			}
+			if (r.empty())
+				break;
+			umodpoly q, rem;
+			poly_divide(q, rem, r0, r);
+			umodpoly snext = poly_sub(s0, poly_mul(q, s));
+			r0.swap(r);
+			r.swap(rem);
+			s0.swap(s);
+			s.swap(snext);
+		}
+	}
+}
+
+// Coefficients (n_0, ..., n_dn, d_1, ..., d_dd) of t -> f(t y + s) with
+// y = (1, z), normalized to d_0 = 1.
+modvector modular_ratinterp::line_coeffs(const modvector& z) const
+{
+	modvector y(1, R->one());
+	y.insert(y.end(), z.begin(), z.end());
+	const umodpoly u = ttree->interpolate(sample_line(tpts, y));
+	umodpoly r, s;
+	poly_ratrecon(r, s, ttree->root(), u, dn);
+	// the leading coefficients vanish on this line, or numerator and
+	// denominator have a common root on it
+	if (r.empty() || int(degree(r)) != dn || int(degree(s)) != dd || zerop(s[0]))
+		throw unlucky_choice();
+	const cln::cl_MI inv = cln::recip(s[0]);
+	modvector c;
+	c.reserve(dn + dd + 1);
+	for (int k = 0; k <= dn; ++k)
+		c.push_back(r[k]*inv);
+	for (int k = 1; k <= dd; ++k)
+		c.push_back(s[k]*inv);
+	return c;
+}
+
+// Zippel's sparse interpolation of all line coefficients as polynomials in
+// z = (y_1, ..., y_{n-1}).  The first variable is interpolated densely, with
+// the other ones fixed at random anchors.  For every further variable z_l
+// the monomials found so far are assumed to be complete: at the points
+// z_k = r_k^q (k < l) their coefficients solve transposed Vandermonde
+// systems, and are then interpolated in z_l.
+void modular_ratinterp::interpolate_coeffs(std::vector<modterms>& polys)
+{
+	const std::size_t m = n - 1;
+	const std::size_t J = dn + dd + 1;
+	polys.assign(J, modterms());
+	if (m == 0) {
+		const modvector c = line_coeffs(modvector());
+		for (std::size_t j = 0; j < J; ++j) {
+			if (!zerop(c[j]))
+				polys[j].push_back(std::make_pair(exp_vector_t(), c[j]));
+		}
+		return;
+	}
+
+	modvector z;
+	z.reserve(m);
+	for (std::size_t i = 0; i < m; ++i)
+		z.push_back(random_elt());
+	const std::size_t npoints = std::max(dn, dd) + 1;
+	const modvector w = random_points(npoints);
+	const subproduct_tree<umodpoly> wtree(w);
+
+	std::vector<modvector> vals;
+	vals.reserve(npoints);
+	for (auto & b : w) {
+		z[0] = b;
+		vals.push_back(line_coeffs(z));
+	}
+	for (std::size_t j = 0; j < J; ++j) {
+		modvector column;
+		column.reserve(npoints);
+		for (auto & v : vals)
+			column.push_back(v[j]);
+		const umodpoly u = wtree.interpolate(column);
+		if (!u.empty() && int(degree(u)) > degree_bound(j))
+			throw unlucky_choice();
+		for (std::size_t e = 0; e < u.size(); ++e) {
+			if (zerop(u[e]))
+				continue;
+			exp_vector_t ev(m, 0);
+			ev[0] = e;
+			polys[j].push_back(std::make_pair(ev, u[e]));
+		}
+	}
+
+	for (std::size_t l = 1; l < m; ++l) {
+		std::size_t T = 0;
+		for (auto & p : polys)
+			T = std::max(T, p.size());
+		if (T == 0)
+			return;
+
+		modvector r;
+		r.reserve(l);
+		while (r.size() < l) {
+			const cln::cl_MI b = random_elt();
+			if (!zerop(b))
+				r.push_back(b);
+		}
+		// samples[i][q] are the line coefficients at z_k = r_k^q, z_l = w_i
+		std::vector<std::vector<modvector>> samples(npoints);
+		for (std::size_t i = 0; i < npoints; ++i) {
+			for (std::size_t k = 0; k < l; ++k)
+				z[k] = R->one();
+			z[l] = w[i];
+			samples[i].reserve(T);
+			for (std::size_t q = 0; q < T; ++q) {
+				samples[i].push_back(line_coeffs(z));
+				for (std::size_t k = 0; k < l; ++k)
+					z[k] = z[k]*r[k];
+			}
+		}
+
+		for (std::size_t j = 0; j < J; ++j) {
+			modterms& pj = polys[j];
+			const std::size_t t = pj.size();
+			if (t == 0)
+				continue;
+			// the values of the monomials at (r_0, ..., r_{l-1}) must be
+			// distinct for the Vandermonde system to be regular
+			modvector nodes;
+			nodes.reserve(t);
+			for (auto & term : pj) {
+				cln::cl_MI v = R->one();
+				for (std::size_t k = 0; k < l; ++k) {
+					if (term.first[k] != 0)
+						v = v*cln::expt_pos(r[k], term.first[k]);
+				}
+				if (std::find(nodes.begin(), nodes.end(), v) != nodes.end())
+					throw unlucky_choice();
+				nodes.push_back(v);
+			}
+			const umodpoly M = subproduct_tree<umodpoly>(nodes).root();
+
+			modterms next;
+			for (std::size_t k = 0; k < t; ++k) {
+				// M/(X - v_k) annihilates all monomials but the k-th one
+				umodpoly b(t, R->zero());
+				b[t - 1] = M[t];
+				for (std::size_t i = t - 1; i-- != 0; )
+					b[i] = M[i + 1] + nodes[k]*b[i + 1];
+				const cln::cl_MI inv = cln::recip(poly_eval(b, nodes[k]));
+				modvector column;
+				column.reserve(npoints);
+				for (std::size_t i = 0; i < npoints; ++i) {
+					cln::cl_MI c = R->zero();
+					for (std::size_t q = 0; q < t; ++q)
+						c = c + b[q]*samples[i][q][j];
+					column.push_back(c*inv);
+				}
+				const umodpoly u = wtree.interpolate(column);
+				int tdeg = 0;
+				for (auto & e : pj[k].first)
+					tdeg += e;
+				if (!u.empty() && tdeg + int(degree(u)) > degree_bound(j))
+					throw unlucky_choice();
+				for (std::size_t e = 0; e < u.size(); ++e) {
+					if (zerop(u[e]))
+						continue;
+					exp_vector_t ev = pj[k].first;
+					ev[l] = e;
+					next.push_back(std::make_pair(ev, u[e]));
+				}
+			}
+			pj.swap(next);
+		}
+	}
+}
+
+// Replace x_i by x_i - s_i in a polynomial given by its terms
+void modular_ratinterp::unshift(std::map<exp_vector_t, cln::cl_MI>& poly) const
+{
+	for (std::size_t i = 0; i < n; ++i) {
+		if (zerop(shift[i]))
+			continue;
+		const cln::cl_MI ms = -shift[i];
+		std::map<exp_vector_t, cln::cl_MI> next;
+		for (auto & term : poly) {
+			// (x_i - s_i)^e = sum_b binomial(e, b) x_i^b (-s_i)^(e-b)
+			const int e = term.first[i];
+			modvector mpow(e + 1, R->one());
+			for (int b = 1; b <= e; ++b)
+				mpow[b] = mpow[b - 1]*ms;
+			cln::cl_MI binom = R->one();
+			exp_vector_t ev = term.first;
+			for (int b = 0; b <= e; ++b) {
+				ev[i] = b;
+				auto it = next.insert(std::make_pair(ev, R->zero())).first;
+				it->second = it->second + term.second*binom*mpow[e - b];
+				binom = binom*R->canonhom(e - b)*cln::recip(R->canonhom(b + 1));
+			}
+		}
+		poly.swap(next);
+	}
+	for (auto it = poly.begin(); it != poly.end(); ) {
+		if (zerop(it->second))
+			it = poly.erase(it);
+		else
+			++it;
+	}
+}
+
+void modular_ratinterp::image(std::map<exp_vector_t, cln::cl_I>& num,
+			      std::map<exp_vector_t, cln::cl_I>& den)
+{
+	num.clear();
+	den.clear();
+	find_shift();
+	modvector y(1, R->one());
+	for (std::size_t i = 1; i < n; ++i)
+		y.push_back(random_elt());
+	find_degrees(y);
+	if (dn < 0) {
+		den[exp_vector_t(n, 0)] = 1;
+		return;
+	}
+
+	tpts = random_points(dn + dd + 1);
+	ttree.reset(new subproduct_tree<umodpoly>(tpts));
+	std::vector<modterms> polys;
+	interpolate_coeffs(polys);
+
+	// homogenize the coefficient of t^k to degree k in y
+	std::map<exp_vector_t, cln::cl_MI> N, D;
+	D[exp_vector_t(n, 0)] = R->one();
+	for (std::size_t j = 0; j < polys.size(); ++j) {
+		const int k = degree_bound(j);
+		std::map<exp_vector_t, cln::cl_MI>& target = int(j) <= dn ? N : D;
+		for (auto & term : polys[j]) {
+			exp_vector_t ev(n, 0);
+			int tdeg = 0;
+			for (std::size_t i = 0; i < n - 1; ++i) {
+				ev[i + 1] = term.first[i];
+				tdeg += term.first[i];
+			}
+			if (tdeg > k)
+				throw unlucky_choice();
+			ev[0] = k - tdeg;
+			target.insert(std::make_pair(ev, term.second));
+		}
+	}
+	unshift(N);
+	unshift(D);
+	if (N.empty() || D.empty())
+		throw unlucky_choice();
+
+	const cln::cl_MI inv = cln::recip(D.rbegin()->second);
+	for (auto & term : N)
+		num[term.first] = R->retract(term.second*inv);
+	for (auto & term : D)
+		den[term.first] = R->retract(term.second*inv);
+}
+
+// Image modulo p with up to three sets of random choices
+static bool modular_image(std::map<exp_vector_t, cln::cl_I>& num,
+			  std::map<exp_vector_t, cln::cl_I>& den,
+			  const modular_evaluator& f, std::size_t n, long p)
+{
+	for (int tries = 0; tries < 3; ++tries) {
+		try {
+			modular_ratinterp(f, n, p).image(num, den);
+			return true;
+		} catch (unlucky_choice &) {
+		}
+	}
+	return false;
+}
+
+static bool same_support(const std::map<exp_vector_t, cln::cl_I>& a,
+			 const std::map<exp_vector_t, cln::cl_I>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j) {
+		if (i->first != j->first)
+			return false;
+	}
+	return true;
+}
+
+// x = a mod q, x = b mod p, 0 <= x < q p
+static void chinese_remainder(std::map<exp_vector_t, cln::cl_I>& a, const cln::cl_I& q,
+			      const std::map<exp_vector_t, cln::cl_I>& b, long p)
+{
+	const cln::cl_I qinv = recip(cln::mod(q, p), p);
+	auto j = b.begin();
+	for (auto i = a.begin(); i != a.end(); ++i, ++j)
+		i->second = i->second + q*cln::mod((j->second - i->second)*qinv, p);
+}
+
+static bool rational_reconstruction(std::map<exp_vector_t, cln::cl_RA>& x,
+				    const std::map<exp_vector_t, cln::cl_I>& a,
+				    const cln::cl_I& m)
+{
+	x.clear();
+	for (auto & term : a) {
+		cln::cl_RA c = 0;
+		if (!rational_reconstruction(c, term.second, m))
+			return false;
+		x.insert(std::make_pair(term.first, c));
+	}
+	return true;
+}
+
+// Value of a polynomial with rational coefficients at x, false if the
+// denominator of a coefficient vanishes
+static bool eval_terms(cln::cl_MI& v, const std::map<exp_vector_t, cln::cl_RA>& poly,
+		       const modvector& x, const cln::cl_modint_ring& R)
+{
+	v = R->zero();
+	for (auto & term : poly) {
+		const cln::cl_MI d = R->canonhom(cln::denominator(term.second));
+		if (zerop(d))
+			return false;
+		cln::cl_MI c = R->canonhom(cln::numerator(term.second))*cln::recip(d);
+		for (std::size_t i = 0; i < x.size(); ++i) {
+			if (term.first[i] != 0)
+				c = c*cln::expt_pos(x[i], term.first[i]);
+		}
+		v = v + c;
+	}
+	return true;
+}
+
+// Check num/den against f at two random points modulo a fresh prime
+static bool verify(modular_evaluator& f, const std::map<exp_vector_t, cln::cl_RA>& num,
+		   const std::map<exp_vector_t, cln::cl_RA>& den, std::size_t n,
+		   primes_factory& pfactory)
+{
+	long p;
+	while (true) {
+		if (!pfactory(p, cln::cl_I(1)))
+			throw std::runtime_error("ratinterp_normal(): out of primes");
+		const cln::cl_modint_ring R = cln::find_modint_ring(p);
+		if (!f.set_ring(R))
+			continue;
+		const random_modint gen(p);
+		int checked = 0;
+		for (int tries = 0; tries < 10 && checked < 2; ++tries) {
+			modvector x;
+			for (std::size_t i = 0; i < n; ++i)
+				x.push_back(R->canonhom(gen()));
+			cln::cl_MI v = R->zero(), nv = R->zero(), dv = R->zero();
+			if (!f(v, x))
+				continue;
+			if (!eval_terms(nv, num, x, R) || !eval_terms(dv, den, x, R))
+				break;
+			if (v*dv != nv)
+				return false;
+			++checked;
+		}
+		if (checked == 2)
+			return true;
+	}
+}
+
+static ex terms_to_ex(const std::map<exp_vector_t, cln::cl_RA>& poly, const exvector& vars)
+{
+	exvector terms;
+	terms.reserve(poly.size());
+	for (auto & term : poly) {
+		exvector tv;
+		tv.reserve(vars.size() + 1);
+		tv.push_back(numeric(term.second));
+		for (std::size_t i = 0; i < vars.size(); ++i) {
+			if (term.first[i] != 0)
+				tv.push_back(pow(vars[i], term.first[i]));
+		}
+		terms.push_back(dynallocate<mul>(tv));
+	}
+	return dynallocate<add>(terms);
+}
+
+/// Number of consecutive primes without an image after which the
+/// denominator is taken to vanish identically.
+static const int max_failed_primes = 16;
+
+void ratinterp_normal(ex& num, ex& den, const ex& e, const exvector& vars)
+{
+	modular_evaluator f(e, vars);
+	const std::size_t n = vars.size();
+	if (n == 0)
+		throw std::invalid_argument("ratinterp_normal(): no variables");
+
+	// accumulated images modulo q, combined from nimages primes
+	std::map<exp_vector_t, cln::cl_I> anum, aden;
+	cln::cl_I q = 0;
+	int nimages = 0, mismatches = 0, failed = 0;
+	primes_factory pfactory;
+	long p;
+	while (true) {
+		if (failed == max_failed_primes)
+			throw pole_error("normal_by_interpolation: division by zero", 1);
+		if (!pfactory(p, cln::cl_I(1)))
+			throw std::runtime_error("ratinterp_normal(): out of primes");
+		std::map<exp_vector_t, cln::cl_I> inum, iden;
+		if (!f.set_ring(cln::find_modint_ring(p)) ||
+		    !modular_image(inum, iden, f, n, p)) {
+			++failed;
+			continue;
+		}
+		failed = 0;
+
+		if (zerop(q)) {
+			anum.swap(inum);
+			aden.swap(iden);
+			q = p;
+			nimages = 1;
+		} else if (same_support(anum, inum) && same_support(aden, iden)) {
+			chinese_remainder(anum, q, inum, p);
+			chinese_remainder(aden, q, iden, p);
+			q = q*p;
+			++nimages;
+		} else {
+			// Images with fewer terms come from unlucky primes, unless
+			// they are in the majority
+			if (inum.size() + iden.size() > anum.size() + aden.size() ||
+			    ++mismatches > nimages) {
+				anum.swap(inum);
+				aden.swap(iden);
+				q = p;
+				nimages = 1;
+				mismatches = 0;
+			}
+			continue;
+		}
+
+		std::map<exp_vector_t, cln::cl_RA> rnum, rden;
+		if (!rational_reconstruction(rnum, anum, q) ||
+		    !rational_reconstruction(rden, aden, q))
+			continue;
+		if (!verify(f, rnum, rden, n, pfactory))
+			continue;
+		num = terms_to_ex(rnum, vars);
+		den = terms_to_ex(rden, vars);
+		return;
+	}
+}
+
+} // namespace GiNaC
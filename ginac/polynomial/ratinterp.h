@@ -0,0 +1,49 @@
+/** @file ratinterp.h
+ *
+ *  Normal form of rational functions by evaluation and sparse rational
+ *  interpolation modulo primes. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_RATINTERP_H
+#define GINAC_RATINTERP_H
+
+#include "ex.h"
+
+namespace GiNaC {
+
+/**
+ * Coprime numerator @a num and denominator @a den of the rational function
+ * @a e in the symbols @a vars, with rational coefficients.
+ *
+ * The expression is only evaluated, never expanded: it is compiled into a
+ * straight-line program over Z_p, and numerator and denominator are
+ * reconstructed from its values by sparse rational interpolation modulo
+ * several primes, Chinese remaindering and rational number reconstruction.
+ * The result is checked at random points modulo a further prime.
+ *
+ * @exception invalid_argument (e is not a rational function in vars with
+ *            rational coefficients)
+ * @exception pole_error (the denominator of e vanishes identically)
+ */
+extern void ratinterp_normal(ex& num, ex& den, const ex& e, const exvector& vars);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_RATINTERP_H
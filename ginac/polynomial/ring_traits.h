@@ -25,6 +25,7 @@
 
 #include <cln/integer.h>
 #include <cln/modinteger.h>
+#include <cln/complex.h>
 
 namespace cln {
 
@@ -56,6 +57,17 @@ static inline cln::cl_MI get_ring_elt(const cln::cl_MI& sample, const int val)
 	return sample.ring()->canonhom(val);
 }
 
+/// Division in the field of (rational, floating point or complex) numbers.
+static inline cln::cl_N div(const cln::cl_N& x, const cln::cl_N& y)
+{
+	return x/y;
+}
+
+static inline cln::cl_N get_ring_elt(const cln::cl_N& sample, const int val)
+{
+	return cln::cl_I(val);
+}
+
 template<typename T>
 static inline T the_one(const T& sample)
 {
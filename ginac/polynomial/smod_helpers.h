@@ -29,6 +29,7 @@
 
 #include <cln/integer.h>
 #include <cln/integer_io.h>
+#include <cln/rational.h>
 
 namespace GiNaC {
 
@@ -69,6 +70,26 @@ static inline cln::cl_I to_cl_I(const ex& e)
 	return cln::the<cln::cl_I>(ex_to<numeric>(e).to_cl_N());
 }
 
+// Rational number n/d = a (mod m) with |n|, d <= sqrt(m/2), by the extended
+// Euclidean algorithm (Wang).  Returns false if there is none.
+static inline bool rational_reconstruction(cln::cl_RA& x, const cln::cl_I& a, const cln::cl_I& m)
+{
+	const cln::cl_I bound = cln::isqrt(m >> 1);
+	cln::cl_I r0 = m, r1 = cln::mod(a, m), t0 = 0, t1 = 1;
+	while (r1 > bound) {
+		const cln::cl_I q = cln::floor1(r0, r1);
+		const cln::cl_I r2 = r0 - q*r1, t2 = t0 - q*t1;
+		r0 = r1;
+		r1 = r2;
+		t0 = t1;
+		t1 = t2;
+	}
+	if (cln::abs(t1) > bound || cln::gcd(r1, t1) != 1)
+		return false;
+	x = cln::cl_RA(r1)/t1;
+	return true;
+}
+
 struct random_modint
 {
 	typedef long value_type;
@@ -0,0 +1,318 @@
+/** @file ratfunc.cpp
+ *
+ *  Implementation of rational functions with factored denominators. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ratfunc.h"
+#include "add.h"
+#include "mul.h"
+#include "normal.h"
+#include "numeric.h"
+#include "operators.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace GiNaC {
+
+namespace {
+
+/** Factor of the merged denominators of two rational functions, with its
+ *  multiplicities in the first and in the second one. */
+struct basis_factor {
+	ex p;
+	int k[2];
+};
+
+typedef std::vector<basis_factor> factor_basis;
+
+void collect_symbols(const ex & e, exset & syms)
+{
+	if (is_a<symbol>(e))
+		syms.insert(e);
+	else
+		for (size_t i = 0; i < e.nops(); ++i)
+			collect_symbols(e.op(i), syms);
+}
+
+/** Makes the expanded polynomial p primitive with a positive leading
+ *  coefficient (taken with respect to its symbols in canonical order) and
+ *  returns the integer removed from it. */
+numeric normalize_factor(ex & p)
+{
+	exset syms;
+	collect_symbols(p, syms);
+	ex lc = p;
+	for (auto & s : syms)
+		lc = lc.lcoeff(s);
+	numeric c = p.integer_content();
+	if (is_exactly_a<numeric>(lc) && ex_to<numeric>(lc).is_negative())
+		c = -c;
+	if (!c.is_equal(*_num1_p))
+		p = (p / c).expand();
+	return c;
+}
+
+/** Multiplies the two denominators described by the basis with p^k0 and
+ *  p^k1, respectively.  A factor of the basis which has a common divisor g
+ *  with p is split into g and its cofactor, so the factors stay pairwise
+ *  coprime.  Numeric parts are collected in c0 and c1. */
+void insert_factor(factor_basis & basis, ex p, int k0, int k1, numeric & c0, numeric & c1)
+{
+	if (k0 == 0 && k1 == 0)
+		return;
+	p = p.expand();
+	if (is_exactly_a<numeric>(p)) {
+		c0 *= ex_to<numeric>(p).power(k0);
+		c1 *= ex_to<numeric>(p).power(k1);
+		return;
+	}
+	const numeric c = normalize_factor(p);
+	c0 *= c.power(k0);
+	c1 *= c.power(k1);
+
+	for (size_t i = 0; i < basis.size(); ++i) {
+		ex cf, cp;
+		const ex g = gcd(basis[i].p, p, &cf, &cp, false);
+		if (is_exactly_a<numeric>(g))
+			continue;
+		const basis_factor f = basis[i];
+		basis.erase(basis.begin() + i);
+		insert_factor(basis, g, f.k[0] + k0, f.k[1] + k1, c0, c1);
+		insert_factor(basis, cf, f.k[0], f.k[1], c0, c1);
+		insert_factor(basis, cp, k0, k1, c0, c1);
+		return;
+	}
+	basis.push_back(basis_factor{p, {k0, k1}});
+}
+
+/** Inserts the factors of a product of powers into the first column of
+ *  the basis. */
+void insert_product(factor_basis & basis, const ex & e, int k, numeric & c)
+{
+	if (is_exactly_a<mul>(e)) {
+		for (size_t i = 0; i < e.nops(); ++i)
+			insert_product(basis, e.op(i), k, c);
+	} else if (is_exactly_a<power>(e) && e.op(1).info(info_flags::posint)) {
+		insert_product(basis, e.op(0), k * ex_to<numeric>(e.op(1)).to_int(), c);
+	} else {
+		numeric unused;
+		insert_factor(basis, e, k, 0, c, unused);
+	}
+}
+
+/** Cancels the common divisors of the numerator n and p^m, where p is
+ *  square-free and coprime to the other factors of the denominator, and
+ *  appends what remains of p^m to fv. */
+void cancel_factor(ex & n, const ex & p, int m, ratfunc::factor_vector & fv)
+{
+	if (m == 0)
+		return;
+	if (is_exactly_a<numeric>(p)) {
+		n = n / pow(p, m);
+		return;
+	}
+	ex cn, cp;
+	const ex g = gcd(n, p, &cn, &cp, false);
+	if (is_exactly_a<numeric>(g)) {
+		// the cofactors of gcd() are not normalized
+		ex q = p.expand();
+		n = n / pow(normalize_factor(q), m);
+		fv.push_back(std::make_pair(q, m));
+		return;
+	}
+	// n/p^m = (n/g)/(g^(m-1) cp^m), and g, cp are coprime
+	n = cn;
+	cancel_factor(n, g, m - 1, fv);
+	cancel_factor(n, cp, m, fv);
+}
+
+} // anonymous namespace
+
+ratfunc::ratfunc() : num(_ex0) { }
+
+ratfunc::ratfunc(const ex & e)
+{
+	if (!e.info(info_flags::rational_function))
+		throw std::invalid_argument("ratfunc::ratfunc(): argument must be a rational function");
+
+	const ex nd = e.numer_denom();
+	factor_basis basis;
+	numeric c = *_num1_p;
+	insert_product(basis, sqrfree(nd.op(1)), 1, c);
+	for (auto & b : basis)
+		factors.push_back(std::make_pair(b.p, b.k[0]));
+	num = (nd.op(0) / c).expand();
+}
+
+ex ratfunc::denom() const
+{
+	exvector d;
+	d.reserve(factors.size());
+	for (auto & f : factors)
+		d.push_back(pow(f.first, f.second));
+	return dynallocate<mul>(d);
+}
+
+ex ratfunc::to_ex() const
+{
+	return num / denom();
+}
+
+ratfunc & ratfunc::operator+=(const ratfunc & other)
+{
+	if (other.num.is_zero())
+		return *this;
+	if (num.is_zero())
+		return *this = other;
+
+	factor_basis basis;
+	numeric c0 = *_num1_p, c1 = *_num1_p;
+	for (auto & f : factors)
+		insert_factor(basis, f.first, f.second, 0, c0, c1);
+	for (auto & f : other.factors)
+		insert_factor(basis, f.first, 0, f.second, c0, c1);
+
+	// Common denominator with the maximal multiplicities.  Each numerator
+	// is coprime to its own denominator, so the sum can only have common
+	// divisors with factors of the same multiplicity in both denominators.
+	exvector co0, co1;
+	factor_vector candidates;
+	factors.clear();
+	for (auto & b : basis) {
+		const int m = std::max(b.k[0], b.k[1]);
+		if (m > b.k[0])
+			co0.push_back(pow(b.p, m - b.k[0]));
+		if (m > b.k[1])
+			co1.push_back(pow(b.p, m - b.k[1]));
+		if (b.k[0] == b.k[1])
+			candidates.push_back(std::make_pair(b.p, m));
+		else
+			factors.push_back(std::make_pair(b.p, m));
+	}
+	num = (num * dynallocate<mul>(co0) / c0 + other.num * dynallocate<mul>(co1) / c1).expand();
+
+	if (num.is_zero()) {
+		factors.clear();
+		return *this;
+	}
+	for (auto & f : candidates)
+		cancel_factor(num, f.first, f.second, factors);
+	num = num.expand();
+	return *this;
+}
+
+ratfunc & ratfunc::operator-=(const ratfunc & other)
+{
+	return *this += -other;
+}
+
+ratfunc & ratfunc::operator*=(const ratfunc & other)
+{
+	if (num.is_zero())
+		return *this;
+	if (other.num.is_zero())
+		return *this = other;
+
+	factor_basis basis;
+	numeric c0 = *_num1_p, c1 = *_num1_p;
+	for (auto & f : factors)
+		insert_factor(basis, f.first, f.second, 0, c0, c1);
+	for (auto & f : other.factors)
+		insert_factor(basis, f.first, 0, f.second, c0, c1);
+
+	// Each numerator can only have common divisors with the factors of the
+	// other denominator, and they are cancelled before the numerators are
+	// multiplied.
+	ex n0 = num, n1 = other.num;
+	factors.clear();
+	for (auto & b : basis) {
+		if (b.k[0] == 0)
+			cancel_factor(n0, b.p, b.k[1], factors);
+		else if (b.k[1] == 0)
+			cancel_factor(n1, b.p, b.k[0], factors);
+		else
+			factors.push_back(std::make_pair(b.p, b.k[0] + b.k[1]));
+	}
+	num = (n0 * n1 / (c0 * c1)).expand();
+	return *this;
+}
+
+ratfunc & ratfunc::operator/=(const ratfunc & other)
+{
+	return *this *= other.inverse();
+}
+
+ratfunc ratfunc::operator-() const
+{
+	ratfunc r(*this);
+	r.num = (-num).expand();
+	return r;
+}
+
+ratfunc ratfunc::inverse() const
+{
+	if (num.is_zero())
+		throw std::overflow_error("ratfunc::inverse(): division by zero");
+
+	factor_basis basis;
+	numeric c = *_num1_p;
+	insert_product(basis, sqrfree(num), 1, c);
+	ratfunc r;
+	for (auto & b : basis)
+		r.factors.push_back(std::make_pair(b.p, b.k[0]));
+	r.num = (denom() / c).expand();
+	return r;
+}
+
+ratfunc operator+(const ratfunc & a, const ratfunc & b)
+{
+	ratfunc r(a);
+	return r += b;
+}
+
+ratfunc operator-(const ratfunc & a, const ratfunc & b)
+{
+	ratfunc r(a);
+	return r -= b;
+}
+
+ratfunc operator*(const ratfunc & a, const ratfunc & b)
+{
+	ratfunc r(a);
+	return r *= b;
+}
+
+ratfunc operator/(const ratfunc & a, const ratfunc & b)
+{
+	ratfunc r(a);
+	return r /= b;
+}
+
+std::ostream & operator<<(std::ostream & os, const ratfunc & r)
+{
+	return os << r.to_ex();
+}
+
+} // namespace GiNaC
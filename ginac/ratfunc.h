@@ -0,0 +1,98 @@
+/** @file ratfunc.h
+ *
+ *  Rational functions with factored denominators. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2023 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_RATFUNC_H
+#define GINAC_RATFUNC_H
+
+#include "ex.h"
+
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+namespace GiNaC {
+
+/** Rational function whose denominator is kept as a product of pairwise
+ *  coprime polynomials with multiplicities (a factor basis).
+ *
+ *  The numerator is an expanded polynomial with rational coefficients, the
+ *  factors of the denominator are expanded primitive polynomials in Z[X].
+ *  Arithmetic merges the factor bases by splitting factors with common
+ *  divisors, and only the factors that can have common divisors with the
+ *  new numerator are cancelled against it.  Unlike normal(), this never multiplies out
+ *  the denominator or computes GCDs of whole numerators and denominators,
+ *  which keeps long computations with rational functions (like the
+ *  coefficients of integration-by-parts reductions) small. */
+class ratfunc
+{
+public:
+	typedef std::vector<std::pair<ex, int>> factor_vector;
+
+	/** The zero rational function. */
+	ratfunc();
+
+	/** Converts a rational function in the symbols of e.  The denominator
+	 *  of the normal form is split into square-free factors.
+	 *  @exception invalid_argument (e is not a rational function) */
+	explicit ratfunc(const ex & e);
+
+	/** The expanded numerator. */
+	const ex & numer() const { return num; }
+
+	/** The factors of the denominator and their multiplicities. */
+	const factor_vector & denom_factors() const { return factors; }
+
+	/** The denominator as a product of powers of its factors. */
+	ex denom() const;
+
+	/** Converts back to an expression numer()/denom(). */
+	ex to_ex() const;
+
+	bool is_zero() const { return num.is_zero(); }
+
+	ratfunc & operator+=(const ratfunc & other);
+	ratfunc & operator-=(const ratfunc & other);
+	ratfunc & operator*=(const ratfunc & other);
+	/** @exception overflow_error (division by zero) */
+	ratfunc & operator/=(const ratfunc & other);
+
+	ratfunc operator-() const;
+
+	/** Multiplicative inverse.
+	 *  @exception overflow_error (division by zero) */
+	ratfunc inverse() const;
+
+private:
+	ex num;
+	factor_vector factors;
+};
+
+ratfunc operator+(const ratfunc & a, const ratfunc & b);
+ratfunc operator-(const ratfunc & a, const ratfunc & b);
+ratfunc operator*(const ratfunc & a, const ratfunc & b);
+ratfunc operator/(const ratfunc & a, const ratfunc & b);
+
+std::ostream & operator<<(std::ostream & os, const ratfunc & r);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_RATFUNC_H
@@ -29,6 +29,7 @@
 #include "utils.h"
 #include "hash_seed.h"
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <limits>
@@ -58,7 +59,7 @@ GINAC_IMPLEMENT_REGISTERED_CLASS_OPT(symmetry, basic,
 // default constructor
 //////////
 
-symmetry::symmetry() :  type(none)
+symmetry::symmetry() :  type(none), nonsymmetric_children(false), cyclic_children(false)
 {
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
@@ -67,13 +68,13 @@ symmetry::symmetry() :  type(none)
 // other constructors
 //////////
 
-symmetry::symmetry(unsigned i) :  type(none)
+symmetry::symmetry(unsigned i) :  type(none), nonsymmetric_children(false), cyclic_children(false)
 {
 	indices.insert(i);
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
 
-symmetry::symmetry(symmetry_type t, const symmetry &c1, const symmetry &c2) :  type(t)
+symmetry::symmetry(symmetry_type t, const symmetry &c1, const symmetry &c2) :  type(t), nonsymmetric_children(false), cyclic_children(false)
 {
 	add(c1); add(c2);
 	setflag(status_flags::evaluated | status_flags::expanded);
@@ -262,28 +263,37 @@ void symmetry::do_print_tree(const print_tree & c, unsigned level) const
 // non-virtual functions in this class
 //////////
 
-bool symmetry::has_nonsymmetric() const
+/** Find the representative (smallest element) of the orbit containing i. */
+static unsigned orbit_find(std::vector<unsigned> & orbit, unsigned i)
 {
-	if (type == antisymmetric || type == cyclic)
-		return true;
-
-	for (auto & i : children)
-		if (ex_to<symmetry>(i).has_nonsymmetric())
-			return true;
-
-	return false;
+	while (orbit[i] != i)
+		i = orbit[i] = orbit[orbit[i]];
+	return i;
 }
 
-bool symmetry::has_cyclic() const
+void symmetry::get_index_orbits(std::vector<unsigned> & orbit) const
 {
-	if (type == cyclic)
-		return true;
-
 	for (auto & i : children)
-		if (ex_to<symmetry>(i).has_cyclic())
-			return true;
+		ex_to<symmetry>(i).get_index_orbits(orbit);
+
+	if (type != none && children.size() > 1) {
+
+		// Corresponding indices of the children can be exchanged
+		const std::set<unsigned> & first = ex_to<symmetry>(children[0]).indices;
+		for (size_t k=1; k<children.size(); ++k) {
+			const std::set<unsigned> & other = ex_to<symmetry>(children[k]).indices;
+			for (auto i = first.begin(), j = other.begin(); i != first.end(); ++i, ++j) {
+				unsigned a = orbit_find(orbit, *i), b = orbit_find(orbit, *j);
+				if (a < b)
+					orbit[b] = a;
+				else
+					orbit[a] = b;
+			}
+		}
+	}
 
-	return false;
+	for (auto & i : indices)
+		orbit[i] = orbit_find(orbit, i);
 }
 
 symmetry &symmetry::add(const symmetry &c)
@@ -304,8 +314,11 @@ symmetry &symmetry::add(const symmetry &c)
 	// Set new index set
 	indices.swap(un);
 
-	// Add child node
+	// Add child node and remember its properties
 	children.push_back(c);
+	child_indices.insert(child_indices.end(), c.indices.begin(), c.indices.end());
+	nonsymmetric_children = nonsymmetric_children || c.has_nonsymmetric();
+	cyclic_children = cyclic_children || c.has_cyclic();
 	return *this;
 }
 
@@ -435,6 +448,69 @@ public:
 	}
 };
 
+/** Nodes with fewer children than this are sorted by exchanging adjacent
+ *  children, which is faster for short sequences. */
+static const size_t sort_children_threshold = 6;
+
+/** Sort the children of a symmetric or antisymmetric node in ascending order
+ *  with an O(n log n) sort, and move the elements of v accordingly. The
+ *  indices of the num children are given child by child in ci.
+ *
+ *  @return the sign of the permutation, or 0 if two children are equal */
+static int sort_children(exvector::iterator v, const std::vector<unsigned> &ci, size_t num, bool &swapped)
+{
+	const size_t block = ci.size() / num;
+
+	auto compare_children = [&](size_t a, size_t b) {
+		for (size_t k=0; k<block; ++k) {
+			int cmpval = v[ci[a*block+k]].compare(v[ci[b*block+k]]);
+			if (cmpval)
+				return cmpval;
+		}
+		return 0;
+	};
+
+	std::vector<size_t> order(num);
+	for (size_t i=0; i<num; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(),
+	                 [&](size_t a, size_t b) { return compare_children(a, b) < 0; });
+
+	int sign = 1;
+	for (size_t i=1; i<num; ++i)
+		if (compare_children(order[i-1], order[i]) == 0)
+			sign = 0;
+
+	// The sign of the permutation follows from its cycle decomposition
+	std::vector<bool> seen(num, false);
+	bool identity = true;
+	for (size_t i=0; i<num; ++i) {
+		if (seen[i])
+			continue;
+		size_t len = 0;
+		for (size_t j=i; !seen[j]; j=order[j]) {
+			seen[j] = true;
+			++len;
+		}
+		if (len > 1)
+			identity = false;
+		if (len % 2 == 0)
+			sign = -sign;
+	}
+	if (identity)
+		return sign;
+
+	// Move the elements into place
+	exvector sorted(ci.size());
+	for (size_t i=0; i<num; ++i)
+		for (size_t k=0; k<block; ++k)
+			sorted[i*block+k].swap(v[ci[order[i]*block+k]]);
+	for (size_t i=0; i<ci.size(); ++i)
+		v[ci[i]].swap(sorted[i]);
+	swapped = true;
+	return sign;
+}
+
 int canonicalize(exvector::iterator v, const symmetry &symm)
 {
 	// Less than two elements? Then do nothing
@@ -462,11 +538,17 @@ int canonicalize(exvector::iterator v, const symmetry &symm)
 	switch (symm.type) {
 		case symmetry::symmetric:
 			// Sort the children in ascending order
-			shaker_sort(first, last, sy_is_less(v), sy_swap(v, something_changed));
+			if (symm.children.size() < sort_children_threshold)
+				shaker_sort(first, last, sy_is_less(v), sy_swap(v, something_changed));
+			else
+				sort_children(v, symm.child_indices, symm.children.size(), something_changed);
 			break;
 		case symmetry::antisymmetric:
 			// Sort the children in ascending order, keeping track of the signum
-			sign *= permutation_sign(first, last, sy_is_less(v), sy_swap(v, something_changed));
+			if (symm.children.size() < sort_children_threshold)
+				sign *= permutation_sign(first, last, sy_is_less(v), sy_swap(v, something_changed));
+			else
+				sign *= sort_children(v, symm.child_indices, symm.children.size(), something_changed);
 			if (sign == 0)
 				return 0;
 			break;
@@ -489,34 +571,27 @@ static ex symm(const ex & e, exvector::const_iterator first, exvector::const_ite
 	if (num < 2)
 		return e;
 
-	// Transform object vector to a lst (for subs())
-	lst orig_lst(first, last);
-
-	// Create index vectors for permutation
-	unsigned *iv = new unsigned[num], *iv2;
-	for (unsigned i=0; i<num; i++)
-		iv[i] = i;
-	iv2 = (asymmetric ? new unsigned[num] : nullptr);
-
-	// Loop over all permutations (the first permutation, which is the
-	// identity, is unrolled)
-	exvector sum_v;
-	sum_v.push_back(e);
-	while (std::next_permutation(iv, iv + num)) {
-		lst new_lst;
-		for (unsigned i=0; i<num; i++)
-			new_lst.append(orig_lst.op(iv[i]));
-		ex term = e.subs(orig_lst, new_lst, subs_options::no_pattern|subs_options::no_index_renaming);
-		if (asymmetric) {
-			memcpy(iv2, iv, num * sizeof(unsigned));
-			term *= permutation_sign(iv2, iv2 + num);
+	// The permutations of the first k objects are the permutations of the
+	// first k-1 objects, each followed by an exchange of one of the first k
+	// objects with the k-th one. So symmetrize over a growing number of
+	// objects, combining equal terms after each step. This keeps the number
+	// of terms small when the expression has symmetries of its own.
+	ex sum = e;
+	for (unsigned k=1; k<num; k++) {
+		exvector sum_v;
+		sum_v.reserve(k + 1);
+		sum_v.push_back(sum);
+		for (unsigned i=0; i<k; i++) {
+			exmap m;
+			m[first[i]] = first[k];
+			m[first[k]] = first[i];
+			ex term = sum.subs(m, subs_options::no_pattern|subs_options::no_index_renaming);
+			sum_v.push_back(asymmetric ? -term : term);
 		}
-		sum_v.push_back(term);
+		sum = dynallocate<add>(sum_v);
+		if (sum.is_zero())
+			return sum;
 	}
-	ex sum = dynallocate<add>(sum_v);
-
-	delete[] iv;
-	delete[] iv2;
 
 	return sum / factorial(numeric(num));
 }
@@ -90,9 +90,15 @@ public:
 	/** Check whether this node actually represents any kind of symmetry. */
 	bool has_symmetry() const {return type != none || !children.empty(); }
 	/** Check whether this node involves anything non symmetric. */
-	bool has_nonsymmetric() const;
+	bool has_nonsymmetric() const {return type == antisymmetric || type == cyclic || nonsymmetric_children;}
 	/** Check whether this node involves a cyclic symmetry. */
-	bool has_cyclic() const;
+	bool has_cyclic() const {return type == cyclic || cyclic_children;}
+
+	/** Compute the orbits of the index positions under the permutations
+	 *  generated by this node. On entry, orbit[i] must be i for all indices
+	 *  of the node; on return, orbit[i] holds the smallest index that index
+	 *  i can be moved to. */
+	void get_index_orbits(std::vector<unsigned> & orbit) const;
 protected:
 	void do_print(const print_context & c, unsigned level) const;
 	void do_print_tree(const print_tree & c, unsigned level) const;
@@ -107,6 +113,16 @@ private:
 
 	/** Vector of child nodes. */
 	exvector children;
+
+	/** Indices of all child nodes, child by child, each in ascending order
+	 *  (used by canonicalize()). */
+	std::vector<unsigned> child_indices;
+
+	/** Does any child node involve anything non symmetric? */
+	bool nonsymmetric_children;
+
+	/** Does any child node involve a cyclic symmetry? */
+	bool cyclic_children;
 };
 GINAC_DECLARE_UNARCHIVER(symmetry); 
 